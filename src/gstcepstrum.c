@@ -29,18 +29,215 @@
  *
  * The message's structure contains some combination of these fields:
  *
- * * #GstClockTime `timestamp`: the timestamp of the buffer that triggered the message.
+ * * #GstClockTime `timestamp`: the time of the first sample of the interval.
  * * #GstClockTime `stream-time`: the stream time of the buffer.
  * * #GstClockTime `running-time`: the running_time of the buffer.
  * * #GstClockTime `duration`: the duration of the buffer.
  * * #GstClockTime `endtime`: the end time of the buffer that triggered the message as stream time (this
  *   is deprecated, as it can be calculated from stream-time + duration)
  * * A #GST_TYPE_LIST value of #gfloat `cepstrum`: the computed mfcc coefficients.
+ * * A #GST_TYPE_LIST value of #gfloat `psd`: the Welch power spectral
+ *   density of the interval, if #GstCepstrum:psd is %TRUE.
+ * * #gfloat `psd-bin-width`: the spacing of the `psd` values in Hz.
+ * * A #GST_TYPE_LIST value of #gfloat `cqt`: the constant-Q power of each
+ *   bin averaged over the interval, if #GstCepstrum:cqt-bins is non-zero.
  *
  * If #GstCepstrum:multi-channel property is set to true. cepstrum field will
  * be each a nested #GST_TYPE_ARRAY value. The first dimension are the
  * channels and the second dimension are the values.
  *
+ * A frame of #GstCepstrum:window-size samples, zero padded to the FFT
+ * length, is analysed every #GstCepstrum:hop-size samples. The optional DC
+ * blocker (#GstCepstrum:remove-dc) and the pre-emphasis filter run once on
+ * every sample as it is read, not on each frame, so overlapping frames see
+ * one continuous filtered signal. For hops much
+ * smaller than the window, a sliding DFT that only updates the bins used by
+ * the Mel filterbank can replace the FFT, see #GstCepstrum:dft-mode.
+ *
+ * Frames are stamped with the time of the first sample of their window and
+ * intervals with the time of their first sample. Both are counted in
+ * samples from the first timestamped buffer after a discontinuity, so the
+ * timestamps stay exact over long streams.
+ *
+ * #GstCepstrum:preset sets all analysis properties to reproduce the
+ * features of HTK, Kaldi or librosa: frame sizes, #GstCepstrum:window-type,
+ * #GstCepstrum:dither, #GstCepstrum:snip-edges, the Mel scale and
+ * normalization, #GstCepstrum:energy-floor and #GstCepstrum:lifter. With a
+ * preset the filterbank is evaluated at the bin frequencies and applied to
+ * the unscaled power spectrum like the toolkit does, or to the magnitude
+ * spectrum for HTK (USEPOWER=F). HTK's C0 comes last, and Kaldi's C0 is
+ * the log energy of the frame (use-energy). The window, filterbank and DCT
+ * matrix are computed once when the analysis is set up. The stream must
+ * have the #GstCepstrum:sample-rate of the preset, other rates fail to
+ * negotiate. Instead of the continuous pre-filter of the input, every frame
+ * is processed on its own in Kaldi's order: dither, removal of the frame
+ * mean, the raw energy for Kaldi's C0 (raw-energy), pre-emphasis within the
+ * frame and the window, and the samples are taken back to their 16 bit
+ * values. Apart from the dither noise and rounding, what remains is that
+ * librosa frames are not centred and its top-db clipping is not applied.
+ *
+ * The Mel filterbank spans #GstCepstrum:low-freq to #GstCepstrum:high-freq.
+ * Only the power of the bins between those edges is computed, so narrowing
+ * the band, e.g. to 300-3400 Hz for telephone speech, also reduces the work
+ * per frame. Power spectra only store those bins, so memory follows the
+ * window and the band rather than the FFT length.
+ *
+ * With #GstCepstrum:feature-type set to `pncc`, power-normalized cepstral
+ * coefficients are computed instead of MFCCs: a gammatone filterbank with
+ * centre frequencies from #GstCepstrum:low-freq to #GstCepstrum:high-freq
+ * (200 to 8000 Hz and 40 filters are typical) replaces the Mel filterbank,
+ * and its band powers go through medium-time noise suppression, temporal
+ * masking, mean power normalization and a power law instead of the log
+ * (see gstcepstrumpncc.h). The smoothing state is kept per channel. The
+ * medium-time window only looks back, so frames are not delayed. Interval
+ * messages average the band values of their frames.
+ *
+ * If #GstCepstrum:psd is %TRUE, the power spectra of the frames of each
+ * interval, taken before noise subtraction, also give its Welch power
+ * spectral density: the frames overlap by the window minus the hop, and the
+ * result is normalized by the window energy and the sample rate and
+ * corrected for the pre-emphasis, in full scale squared per Hz, one-sided.
+ * Groups of #GstCepstrum:psd-decimation bins are averaged into one value.
+ * This shares the FFT of the MFCC analysis instead of running a separate
+ * `spectrum` element. The DC blocker is not compensated.
+ *
+ * With #GstCepstrum:cqt-bins non-zero, a constant-Q transform of every
+ * frame is computed from its FFT with the sparse spectral kernels of Brown
+ * and Puckette, #GstCepstrum:cqt-bins-per-octave bins per octave from
+ * #GstCepstrum:cqt-min-freq up. The kernels are computed once and only keep
+ * the bins around their centre frequency, so the cost per frame is bounded.
+ * A bin can be no longer than the analysis window: bins below about
+ * 17 x sample rate / window size Hz at 12 bins per octave lose resolution,
+ * so low notes need long windows. Multi-octave processing with decimation
+ * is not implemented, every octave comes from the full rate FFT.
+ *
+ * If #GstCepstrum:noise-reduction is %TRUE, the noise floor of every channel
+ * is tracked with minimum statistics and subtracted from the power spectrum
+ * of each frame before the Mel filterbank (see gstcepstrumnoise.h). The
+ * audio passing through the element is not modified.
+ *
+ * If #GstCepstrum:emit-signals is %TRUE, the #GstCepstrum::new-features signal
+ * is emitted from the streaming thread for every analysis frame, giving
+ * direct access to the coefficients without going through the bus. The
+ * frames of each buffer are emitted after it is analysed, with the element
+ * unlocked.
+ *
+ * If #GstCepstrum:history-duration is non-zero, the feature frames of that
+ * much recent audio are kept in a ring and can be pulled at any time with
+ * the #GstCepstrum::get-history action signal.
+ *
+ * With #GstCepstrum:analysis-threads larger than 1, the frames of each
+ * buffer are windowed and transformed on a pool of threads while the
+ * coefficients are still computed and delivered in stream order, giving the
+ * same results as the sequential analysis. This pays off for offline
+ * processing with large buffers, e.g. a file source with a large blocksize.
+ *
+ * Very large transforms can be split instead: with FFTW built with thread
+ * support, every FFT of at least 16384 points runs on
+ * #GstCepstrum:fft-threads threads from the worker pool FFTW shares between
+ * all plans. The property has no effect with the GStreamer FFT.
+ *
+ * If #GstCepstrum:change-threshold is non-zero, a `cepstrum` message is only
+ * posted when the coefficients moved by more than the threshold, according
+ * to #GstCepstrum:change-metric, since the last posted message, or when
+ * #GstCepstrum:max-silence passed without a message.
+ *
+ * If #GstCepstrum:scorer-module is set, the given module is loaded and fed
+ * batches of #GstCepstrum:scorer-batch feature frames from the streaming
+ * thread. A shorter batch with the frames left is scored at a discontinuity
+ * and at the end of the stream. After each batch an element message named
+ * `cepstrum-score` is posted, containing:
+ *
+ * * #GstClockTime `timestamp`: the timestamp of the first frame of the batch.
+ * * #GstClockTime `running-time`: the running_time of the first frame.
+ * * #guint `num-frames`: the number of frames scored.
+ * * #guint `num-outputs`: the number of scores per frame.
+ * * #GstBuffer `scores`: `num-frames` x `num-outputs` packed #gfloat scores.
+ *
+ * See gstcepstrumscorer.h for the module interface.
+ *
+ * If #GstCepstrum:gmm-model is set, every frame is classified with the given
+ * diagonal covariance GMM (see gstcepstrumgmm.h for the file format). The
+ * per class log-likelihoods are smoothed over #GstCepstrum:gmm-smoothing
+ * frames and an element message named `cepstrum-gmm` is posted whenever the
+ * smoothed decision changes:
+ *
+ * * #GstClockTime `timestamp`: the timestamp of the frame that changed it.
+ * * #GstClockTime `running-time`: the running_time of that frame.
+ * * #guint `class`: the index of the most likely class.
+ * * #gfloat `confidence`: the posterior of that class from the smoothed scores.
+ *
+ * If #GstCepstrum:template-dir is set, every `.dtw` template file in it is
+ * matched against the frame stream with subsequence DTW (see
+ * gstcepstrumdtw.h for the file format). For every match whose mean frame
+ * distance is below #GstCepstrum:match-threshold an element message named
+ * `cepstrum-match` is posted, at the latest on a discontinuity or EOS:
+ *
+ * * #gchararray `template`: the template file name without extension.
+ * * #GstClockTime `timestamp`: the timestamp of the first matched frame.
+ * * #GstClockTime `running-time`: the running_time of the first matched frame.
+ * * #GstClockTime `duration`: the time between the first and last matched frame.
+ * * #gfloat `distance`: the mean frame distance along the match.
+ *
+ * If #GstCepstrum:fingerprint is %TRUE, landmark hashes are computed from the
+ * power spectrum of every frame (see gstcepstrumfingerprint.h) and posted
+ * after each interval as an element message named `cepstrum-fingerprint`:
+ *
+ * * #GstClockTime `timestamp`: the timestamp of the first anchor frame.
+ * * #GstClockTime `running-time`: the running_time of the first anchor frame.
+ * * #guint `num-hashes`: the number of hashes.
+ * * #GstBuffer `hashes`: `num-hashes` records of two native endian #guint32,
+ *   the hash and the anchor time in microseconds relative to `timestamp`.
+ *
+ * If #GstCepstrum:onsets is %TRUE, onsets are detected from the spectral
+ * flux of the log Mel energies of every frame (see gstcepstrumonset.h), or
+ * of the log gammatone energies before the power law in PNCC mode, and each
+ * one is posted as an element message named `cepstrum-onset`:
+ *
+ * * #GstClockTime `timestamp`: the timestamp of the onset frame.
+ * * #GstClockTime `running-time`: the running_time of the onset frame.
+ * * #gfloat `strength`: how far the flux exceeded its median.
+ *
+ * If #GstCepstrum:lsh-index is set, the given random projection index is
+ * memory-mapped (see gstcepstrumlsh.h for the file format) and queried with
+ * the coefficients of each interval, or of each frame if
+ * #GstCepstrum:lsh-per-frame is %TRUE. The nearest entries are posted as an
+ * element message named `cepstrum-lsh`:
+ *
+ * * #GstClockTime `timestamp`: the timestamp of the interval or frame queried.
+ * * #GstClockTime `running-time`: the running_time of the query.
+ * * A #GST_TYPE_ARRAY value of #guint `ids`: the nearest reference entries.
+ * * A #GST_TYPE_ARRAY value of #guint `distances`: their hamming distances.
+ *
+ * If #GstCepstrum:multi-channel is %TRUE and #GstCepstrum:tdoa-pairs lists
+ * channel pairs, the time delay between the channels of each pair is
+ * estimated with GCC-PHAT from the spectra of every frame and posted as an
+ * element message named `cepstrum-tdoa`:
+ *
+ * * #GstClockTime `timestamp`: the timestamp of the frame.
+ * * #GstClockTime `running-time`: the running_time of the frame.
+ * * A #GST_TYPE_ARRAY value of #gfloat `delays`: the delay of each pair in
+ *   seconds, positive when the first channel of the pair lags the second.
+ *
+ * If #GstCepstrum:modulation-frames is non-zero, the log Mel energies (the
+ * log gammatone energies before the power law in PNCC mode) of the last
+ * #GstCepstrum:modulation-frames frames on the hop grid are kept in one ring
+ * per band, so that the envelopes are sampled every #GstCepstrum:hop-size
+ * samples; the extra frame of an interval too short for a hop is left out.
+ * Every #GstCepstrum:modulation-hop frames the modulation spectrum of
+ * each band, the power spectrum of its Hann windowed envelope without its
+ * mean, is computed with one batched FFT over all bands and posted as an
+ * element message named `cepstrum-modulation`. In multi-channel mode the
+ * first channel is used.
+ *
+ * * #GstClockTime `timestamp`: the timestamp of the last frame of the envelopes.
+ * * #GstClockTime `running-time`: the running_time of that frame.
+ * * #GstClockTime `duration`: the time the envelopes span.
+ * * #guint `num-bands`: the number of filterbank bands.
+ * * #guint `num-bins`: the number of modulation frequencies per band.
+ * * #gfloat `bin-width`: the spacing of the modulation frequencies in Hz.
+ * * #GstBuffer `power`: `num-bands` x `num-bins` packed #gfloat powers.
+ *
  * ## Example application
  *
  * {{ tests/examples/cepstrum/cepstrum-example.c }}
@@ -55,8 +252,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <float.h>
 #include <fftw3.h>
 #include "gstcepstrum.h"
+#include "gstcepstrumprobes.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_cepstrum_debug);
 #define GST_CAT_DEFAULT gst_cepstrum_debug
@@ -74,38 +273,297 @@ GST_DEBUG_CATEGORY_STATIC (gst_cepstrum_debug);
 
 /* properties */
 #define DEFAULT_POST_MESSAGES	    TRUE
+#define DEFAULT_EMIT_SIGNALS      FALSE
 #define DEFAULT_MULTI_CHANNEL     FALSE
 #define DEFAULT_INTERVAL		      (GST_SECOND / 10)
 #define DEFAULT_NUM_COEFFS        13
+#define DEFAULT_NUM_FILTERS       0
+#define DEFAULT_PRESET            GST_CEPSTRUM_PRESET_NONE
+#define DEFAULT_FEATURE_TYPE      GST_CEPSTRUM_FEATURE_TYPE_MFCC
 #define DEFAULT_SAMPLE_RATE       16000
 #define DEFAULT_FFT_SIZE          512
 #define DEFAULT_WINDOW_SIZE       512
 #define DEFAULT_HOP_SIZE          256
+#define DEFAULT_SNIP_EDGES        FALSE
+#define DEFAULT_WINDOW_TYPE       GST_CEPSTRUM_WINDOW_HAMMING
+#define DEFAULT_DFT_MODE          GST_CEPSTRUM_DFT_MODE_AUTO
+#define DEFAULT_LOW_FREQ          0.0
+#define DEFAULT_HIGH_FREQ         0.0
+#define DEFAULT_MEL_SCALE         GST_CEPSTRUM_MEL_SCALE_HTK
+#define DEFAULT_MEL_NORM          GST_CEPSTRUM_MEL_NORM_NONE
+#define DEFAULT_ENERGY_FLOOR      1e-10
+#define DEFAULT_LIFTER            0.0
 #define DEFAULT_USE_PREEMPHASIS   TRUE
 #define DEFAULT_PREEMPHASIS_COEFF 0.97
+#define DEFAULT_REMOVE_DC         FALSE
+#define DEFAULT_DITHER            0.0
+#define DEFAULT_NOISE_REDUCTION   FALSE
+#define DEFAULT_NOISE_OVERSUBTRACTION 1.0
+#define DEFAULT_CHANGE_THRESHOLD  0.0
+#define DEFAULT_CHANGE_METRIC     GST_CEPSTRUM_CHANGE_METRIC_L2
+#define DEFAULT_MAX_SILENCE       0
+#define DEFAULT_SCORER_MODULE     NULL
+#define DEFAULT_SCORER_OPTIONS    NULL
+#define DEFAULT_SCORER_BATCH      1
+#define DEFAULT_GMM_MODEL         NULL
+#define DEFAULT_GMM_SMOOTHING     10
+#define DEFAULT_TEMPLATE_DIR      NULL
+#define DEFAULT_MATCH_THRESHOLD   10.0
+#define DEFAULT_FINGERPRINT       FALSE
+#define DEFAULT_PSD               FALSE
+#define DEFAULT_PSD_DECIMATION    1
+#define DEFAULT_CQT_BINS          0
+#define DEFAULT_CQT_BINS_PER_OCTAVE 12
+#define DEFAULT_CQT_MIN_FREQ      32.703196     /* C1 */
+#define DEFAULT_ONSETS            FALSE
+#define DEFAULT_ONSET_THRESHOLD   0.3
+#define DEFAULT_ONSET_WINDOW      16
+#define DEFAULT_LSH_INDEX         NULL
+#define DEFAULT_LSH_NUM_RESULTS   5
+#define DEFAULT_LSH_PER_FRAME     FALSE
+#define DEFAULT_TDOA_PAIRS        NULL
+#define DEFAULT_TDOA_MAX_DELAY    0
+#define DEFAULT_HISTORY_DURATION  0
+#define DEFAULT_MODULATION_FRAMES 0
+#define DEFAULT_MODULATION_HOP    0
+#define DEFAULT_ANALYSIS_THREADS  1
+#define DEFAULT_FFT_THREADS       1
+
+/* minimum statistics window of the noise tracker */
+#define NOISE_SUBWINDOW           (GST_SECOND / 4)
+#define NOISE_NUM_SUBWINDOWS      8
+
+/* dither is given in units of a 16 bit sample, like Kaldi does */
+#define DITHER_SCALE              (1.0 / 32768.0)
+
+/* corner frequency of the DC blocker in Hz */
+#define DC_BLOCK_CUTOFF           20.0
+
+/* constant-Q kernel spectra are evaluated over this many times the kernel
+ * resolution on each side of the centre, and their bins below this
+ * fraction of the peak dropped */
+#define CQT_KERNEL_LOBES          4
+#define CQT_KERNEL_THRESHOLD      0.005
+
+/* gammatone weights below this fraction of the peak are dropped */
+#define GAMMATONE_MIN_WEIGHT      1e-3
+
+/* smallest transform planned for several FFTW threads */
+#define FFT_THREADS_MIN_SIZE      16384
+
+/* largest window, hop and FFT length */
+#define MAX_FRAME_SIZE            (1 << 18)
+
+/* memory the buffers of one analysis batch may take */
+#define BATCH_MAX_BYTES           (64 << 20)
+
+/* frames queued per analysis thread before a batch is run */
+#define FRAMES_PER_THREAD         16
 
 
 
+enum
+{
+  SIGNAL_NEW_FEATURES,
+  SIGNAL_GET_HISTORY,
+  LAST_SIGNAL
+};
+
 enum
 {
   PROP_0,
   PROP_POST_MESSAGES,
+  PROP_EMIT_SIGNALS,
   PROP_INTERVAL,
   PROP_NUM_CEPSTRAL_COEFFS,
+  PROP_NUM_FILTERS,
+  PROP_PRESET,
+  PROP_FEATURE_TYPE,
   PROP_SAMPLE_RATE,
   PROP_FFT_SIZE,
   PROP_WINDOW_SIZE,
   PROP_HOP_SIZE,
+  PROP_SNIP_EDGES,
+  PROP_WINDOW_TYPE,
+  PROP_DFT_MODE,
+  PROP_LOW_FREQ,
+  PROP_HIGH_FREQ,
+  PROP_MEL_SCALE,
+  PROP_MEL_NORM,
+  PROP_ENERGY_FLOOR,
+  PROP_LIFTER,
   PROP_USE_PREEMPHASIS,
   PROP_PREEMPHASIS_COEFF,
-  PROP_MULTI_CHANNEL
+  PROP_REMOVE_DC,
+  PROP_DITHER,
+  PROP_NOISE_REDUCTION,
+  PROP_NOISE_OVERSUBTRACTION,
+  PROP_MULTI_CHANNEL,
+  PROP_CHANGE_THRESHOLD,
+  PROP_CHANGE_METRIC,
+  PROP_MAX_SILENCE,
+  PROP_SCORER_MODULE,
+  PROP_SCORER_OPTIONS,
+  PROP_SCORER_BATCH,
+  PROP_GMM_MODEL,
+  PROP_GMM_SMOOTHING,
+  PROP_TEMPLATE_DIR,
+  PROP_MATCH_THRESHOLD,
+  PROP_FINGERPRINT,
+  PROP_PSD,
+  PROP_PSD_DECIMATION,
+  PROP_CQT_BINS,
+  PROP_CQT_BINS_PER_OCTAVE,
+  PROP_CQT_MIN_FREQ,
+  PROP_ONSETS,
+  PROP_ONSET_THRESHOLD,
+  PROP_ONSET_WINDOW,
+  PROP_LSH_INDEX,
+  PROP_LSH_NUM_RESULTS,
+  PROP_LSH_PER_FRAME,
+  PROP_TDOA_PAIRS,
+  PROP_TDOA_MAX_DELAY,
+  PROP_HISTORY_DURATION,
+  PROP_MODULATION_FRAMES,
+  PROP_MODULATION_HOP,
+  PROP_ANALYSIS_THREADS,
+  PROP_FFT_THREADS
 };
 
+#define GST_TYPE_CEPSTRUM_CHANGE_METRIC (gst_cepstrum_change_metric_get_type ())
+static GType
+gst_cepstrum_change_metric_get_type (void)
+{
+  static GType metric_type = 0;
+  static const GEnumValue metrics[] = {
+    {GST_CEPSTRUM_CHANGE_METRIC_L2, "Euclidean distance", "l2"},
+    {GST_CEPSTRUM_CHANGE_METRIC_COSINE, "Cosine distance", "cosine"},
+    {0, NULL, NULL}
+  };
+
+  if (!metric_type) {
+    metric_type = g_enum_register_static ("GstCepstrumChangeMetric", metrics);
+  }
+  return metric_type;
+}
+
+#define GST_TYPE_CEPSTRUM_DFT_MODE (gst_cepstrum_dft_mode_get_type ())
+static GType
+gst_cepstrum_dft_mode_get_type (void)
+{
+  static GType mode_type = 0;
+  static const GEnumValue modes[] = {
+    {GST_CEPSTRUM_DFT_MODE_AUTO, "Cheapest for the settings", "auto"},
+    {GST_CEPSTRUM_DFT_MODE_FFT, "FFT of every frame", "fft"},
+    {GST_CEPSTRUM_DFT_MODE_SLIDING, "Sliding DFT of the filterbank bins",
+        "sliding"},
+    {0, NULL, NULL}
+  };
+
+  if (!mode_type) {
+    mode_type = g_enum_register_static ("GstCepstrumDftMode", modes);
+  }
+  return mode_type;
+}
+
+#define GST_TYPE_CEPSTRUM_PRESET (gst_cepstrum_preset_get_type ())
+static GType
+gst_cepstrum_preset_get_type (void)
+{
+  static GType preset_type = 0;
+  static const GEnumValue presets[] = {
+    {GST_CEPSTRUM_PRESET_NONE, "No preset", "none"},
+    {GST_CEPSTRUM_PRESET_HTK, "HTK HCopy", "htk"},
+    {GST_CEPSTRUM_PRESET_KALDI, "Kaldi compute-mfcc-feats", "kaldi"},
+    {GST_CEPSTRUM_PRESET_LIBROSA, "librosa.feature.mfcc", "librosa"},
+    {0, NULL, NULL}
+  };
+
+  if (!preset_type) {
+    preset_type = g_enum_register_static ("GstCepstrumPreset", presets);
+  }
+  return preset_type;
+}
+
+#define GST_TYPE_CEPSTRUM_FEATURE_TYPE (gst_cepstrum_feature_type_get_type ())
+static GType
+gst_cepstrum_feature_type_get_type (void)
+{
+  static GType feature_type = 0;
+  static const GEnumValue types[] = {
+    {GST_CEPSTRUM_FEATURE_TYPE_MFCC, "Mel-frequency cepstral coefficients",
+        "mfcc"},
+    {GST_CEPSTRUM_FEATURE_TYPE_PNCC, "Power-normalized cepstral coefficients",
+        "pncc"},
+    {0, NULL, NULL}
+  };
+
+  if (!feature_type) {
+    feature_type = g_enum_register_static ("GstCepstrumFeatureType", types);
+  }
+  return feature_type;
+}
+
+#define GST_TYPE_CEPSTRUM_WINDOW (gst_cepstrum_window_get_type ())
+static GType
+gst_cepstrum_window_get_type (void)
+{
+  static GType window_type = 0;
+  static const GEnumValue windows[] = {
+    {GST_CEPSTRUM_WINDOW_HAMMING, "Hamming", "hamming"},
+    {GST_CEPSTRUM_WINDOW_HANN, "Periodic Hann", "hann"},
+    {GST_CEPSTRUM_WINDOW_POVEY, "Povey (Kaldi)", "povey"},
+    {GST_CEPSTRUM_WINDOW_RECTANGULAR, "Rectangular", "rectangular"},
+    {0, NULL, NULL}
+  };
+
+  if (!window_type) {
+    window_type = g_enum_register_static ("GstCepstrumWindow", windows);
+  }
+  return window_type;
+}
+
+#define GST_TYPE_CEPSTRUM_MEL_SCALE (gst_cepstrum_mel_scale_get_type ())
+static GType
+gst_cepstrum_mel_scale_get_type (void)
+{
+  static GType scale_type = 0;
+  static const GEnumValue scales[] = {
+    {GST_CEPSTRUM_MEL_SCALE_HTK, "HTK", "htk"},
+    {GST_CEPSTRUM_MEL_SCALE_SLANEY, "Slaney (Auditory Toolbox)", "slaney"},
+    {0, NULL, NULL}
+  };
+
+  if (!scale_type) {
+    scale_type = g_enum_register_static ("GstCepstrumMelScale", scales);
+  }
+  return scale_type;
+}
+
+#define GST_TYPE_CEPSTRUM_MEL_NORM (gst_cepstrum_mel_norm_get_type ())
+static GType
+gst_cepstrum_mel_norm_get_type (void)
+{
+  static GType norm_type = 0;
+  static const GEnumValue norms[] = {
+    {GST_CEPSTRUM_MEL_NORM_NONE, "Unit peak", "none"},
+    {GST_CEPSTRUM_MEL_NORM_SLANEY, "Unit area", "slaney"},
+    {0, NULL, NULL}
+  };
+
+  if (!norm_type) {
+    norm_type = g_enum_register_static ("GstCepstrumMelNorm", norms);
+  }
+  return norm_type;
+}
+
 #define gst_cepstrum_parent_class parent_class
 G_DEFINE_TYPE (GstCepstrum, gst_cepstrum, GST_TYPE_AUDIO_FILTER);
 GST_ELEMENT_REGISTER_DEFINE (cepstrum, "cepstrum", GST_RANK_NONE,
     GST_TYPE_CEPSTRUM);
 
+static guint gst_cepstrum_signals[LAST_SIGNAL] = { 0 };
+
 static void gst_cepstrum_finalize (GObject * object);
 static void gst_cepstrum_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -115,11 +573,31 @@ static gboolean gst_cepstrum_start (GstBaseTransform * trans);
 static gboolean gst_cepstrum_stop (GstBaseTransform * trans);
 static GstFlowReturn gst_cepstrum_transform_ip (GstBaseTransform * trans,
     GstBuffer * in);
+static gboolean gst_cepstrum_sink_event (GstBaseTransform * trans,
+    GstEvent * event);
+static void gst_cepstrum_dtw_drain (GstCepstrum * cepstrum);
+static void gst_cepstrum_scorer_run (GstCepstrum * cepstrum);
 static gboolean gst_cepstrum_setup (GstAudioFilter * base,
     const GstAudioInfo * info);
-static void alloc_mel_filterbank (gfloat **fbank, gint nfilts,
-          gint sample_rate, gint nfft);
-static void free_mel_filterbank (gfloat **fbank, gint nfilts);
+static void alloc_mel_filterbank (GstCepstrumMelFilter *fbank, gint nfilts,
+          gint sample_rate, gint nfft, gfloat low_freq, gfloat high_freq,
+          GstCepstrumMelScale scale, GstCepstrumMelNorm norm,
+          GstCepstrumPreset preset, gdouble gain);
+static void alloc_gammatone_filterbank (GstCepstrumMelFilter *fbank,
+    gint nfilts, gint sample_rate, gint nfft, gfloat low_freq,
+    gfloat high_freq, gdouble gain);
+static void free_mel_filterbank (GstCepstrumMelFilter *fbank, gint nfilts);
+static guint alloc_cqt_kernels (GstCepstrum * cepstrum, guint nfft);
+static void free_cqt_kernels (GstCepstrum * cepstrum);
+static void compute_window (gfloat *window, guint size,
+          GstCepstrumWindow type);
+static void compute_dct_matrix (gfloat *dct, guint in_size, guint out_size,
+          gfloat lifter, GstCepstrumPreset preset);
+static void gst_cepstrum_scorer_open (GstCepstrum * cepstrum);
+static void gst_cepstrum_scorer_close (GstCepstrum * cepstrum);
+static GstBuffer *gst_cepstrum_get_history (GstCepstrum * cepstrum,
+    guint64 duration);
+static void gst_cepstrum_analysis_func (gpointer data, gpointer user_data);
 
 
 static void
@@ -138,6 +616,7 @@ gst_cepstrum_class_init (GstCepstrumClass * klass)
   trans_class->start = GST_DEBUG_FUNCPTR (gst_cepstrum_start);
   trans_class->stop = GST_DEBUG_FUNCPTR (gst_cepstrum_stop);
   trans_class->transform_ip = GST_DEBUG_FUNCPTR (gst_cepstrum_transform_ip);
+  trans_class->sink_event = GST_DEBUG_FUNCPTR (gst_cepstrum_sink_event);
   trans_class->passthrough_on_same_caps = TRUE;
 
   filter_class->setup = GST_DEBUG_FUNCPTR (gst_cepstrum_setup);
@@ -148,11 +627,36 @@ gst_cepstrum_class_init (GstCepstrumClass * klass)
           "passed interval", DEFAULT_POST_MESSAGES,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_EMIT_SIGNALS,
+      g_param_spec_boolean ("emit-signals", "Emit signals",
+          "Emit new-features signals for every analysis frame",
+          DEFAULT_EMIT_SIGNALS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class, PROP_MULTI_CHANNEL,
       g_param_spec_boolean ("multi-channel", "Multichannel results",
           "Send separate results for each channel",
           DEFAULT_MULTI_CHANNEL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_CHANGE_THRESHOLD,
+      g_param_spec_float ("change-threshold", "Change threshold",
+          "Only post a message when the coefficients changed by more than "
+          "this since the last message (0 = post every interval)",
+          0.0, G_MAXFLOAT, DEFAULT_CHANGE_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CHANGE_METRIC,
+      g_param_spec_enum ("change-metric", "Change metric",
+          "Distance used to compare coefficients with the last message",
+          GST_TYPE_CEPSTRUM_CHANGE_METRIC, DEFAULT_CHANGE_METRIC,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_SILENCE,
+      g_param_spec_uint64 ("max-silence", "Maximum silence",
+          "Post a message after this many nanoseconds without one, even "
+          "if the coefficients did not change (0 = never)",
+          0, G_MAXUINT64, DEFAULT_MAX_SILENCE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class, PROP_INTERVAL,
       g_param_spec_uint64 ("interval", "Interval",
           "Interval of time between message posts (in nanoseconds)",
@@ -162,31 +666,108 @@ gst_cepstrum_class_init (GstCepstrumClass * klass)
   g_object_class_install_property (gobject_class, PROP_NUM_CEPSTRAL_COEFFS,
       g_param_spec_uint ("num-coeffs", "Number of MFCC coefficients",
           "Number of MFCC coefficients to compute",
-          1, 512, DEFAULT_NUM_COEFFS,
+          1, 2048, DEFAULT_NUM_COEFFS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_NUM_FILTERS,
+      g_param_spec_uint ("num-filters", "Number of Mel filters",
+          "Number of filters in the Mel filterbank (0 = twice num-coeffs)",
+          0, 8192, DEFAULT_NUM_FILTERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PRESET,
+      g_param_spec_enum ("preset", "Preset",
+          "Set all analysis properties to reproduce the features of a "
+          "toolkit; set it before any property it should not override. The "
+          "stream must have the sample-rate of the preset. Frames are "
+          "pre-processed one by one like the toolkit does; librosa frames "
+          "are not centred",
+          GST_TYPE_CEPSTRUM_PRESET, DEFAULT_PRESET,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FEATURE_TYPE,
+      g_param_spec_enum ("feature-type", "Feature type",
+          "Cepstral features computed from each frame",
+          GST_TYPE_CEPSTRUM_FEATURE_TYPE, DEFAULT_FEATURE_TYPE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_SAMPLE_RATE,
       g_param_spec_uint ("sample-rate", "Sample rate",
-          "Audio sample rate",
-          0, 92000, DEFAULT_SAMPLE_RATE,
+          "Sample rate the preset frame sizes are for, the analysis itself "
+          "follows the caps",
+          0, 384000, DEFAULT_SAMPLE_RATE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_FFT_SIZE,
       g_param_spec_uint ("fft-size", "FFT size",
           "FFT size for MFCC computation",
-          0, 4096, DEFAULT_FFT_SIZE,
+          0, MAX_FRAME_SIZE / 2 + 1, DEFAULT_FFT_SIZE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_WINDOW_SIZE,
       g_param_spec_uint ("window-size", "Window size",
           "Window size for MFCC computation",
-          0, 4096, DEFAULT_WINDOW_SIZE,
+          0, MAX_FRAME_SIZE, DEFAULT_WINDOW_SIZE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_HOP_SIZE,
       g_param_spec_uint ("hop-size", "Hop size",
           "Hop size for MFCC computation",
-          0, 4096, DEFAULT_HOP_SIZE,
+          0, MAX_FRAME_SIZE, DEFAULT_HOP_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SNIP_EDGES,
+      g_param_spec_boolean ("snip-edges", "Snip edges",
+          "Only analyse frames that lie completely within the stream, "
+          "instead of zero padding its start", DEFAULT_SNIP_EDGES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_WINDOW_TYPE,
+      g_param_spec_enum ("window-type", "Window type",
+          "Window applied to each frame",
+          GST_TYPE_CEPSTRUM_WINDOW, DEFAULT_WINDOW_TYPE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DFT_MODE,
+      g_param_spec_enum ("dft-mode", "DFT mode",
+          "How the spectrum of each frame is computed",
+          GST_TYPE_CEPSTRUM_DFT_MODE, DEFAULT_DFT_MODE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_LOW_FREQ,
+      g_param_spec_float ("low-freq", "Low frequency",
+          "Lower edge of the Mel filterbank in Hz",
+          0.0, G_MAXFLOAT, DEFAULT_LOW_FREQ,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_HIGH_FREQ,
+      g_param_spec_float ("high-freq", "High frequency",
+          "Upper edge of the Mel filterbank in Hz (0 = half the sample rate)",
+          0.0, G_MAXFLOAT, DEFAULT_HIGH_FREQ,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MEL_SCALE,
+      g_param_spec_enum ("mel-scale", "Mel scale",
+          "Formula converting frequencies to Mel",
+          GST_TYPE_CEPSTRUM_MEL_SCALE, DEFAULT_MEL_SCALE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MEL_NORM,
+      g_param_spec_enum ("mel-norm", "Mel normalization",
+          "Normalization of the Mel filters",
+          GST_TYPE_CEPSTRUM_MEL_NORM, DEFAULT_MEL_NORM,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ENERGY_FLOOR,
+      g_param_spec_float ("energy-floor", "Energy floor",
+          "Floor applied to the Mel energies before taking the log",
+          G_MINFLOAT, G_MAXFLOAT, DEFAULT_ENERGY_FLOOR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_LIFTER,
+      g_param_spec_float ("lifter", "Cepstral lifter",
+          "Cepstral liftering coefficient (0 = no liftering)",
+          0.0, 1000.0, DEFAULT_LIFTER,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_USE_PREEMPHASIS,
@@ -199,6 +780,230 @@ gst_cepstrum_class_init (GstCepstrumClass * klass)
       "Coefficient for the pre-emphasis filter",
       0.0, 1.0, DEFAULT_PREEMPHASIS_COEFF, G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class, PROP_REMOVE_DC,
+      g_param_spec_boolean ("remove-dc", "Remove DC",
+          "Whether to apply a DC blocking filter before the pre-emphasis",
+          DEFAULT_REMOVE_DC, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DITHER,
+      g_param_spec_float ("dither", "Dither",
+          "Standard deviation of the Gaussian dither added to the input, in "
+          "16 bit sample units (0 = no dither)",
+          0.0, 32768.0, DEFAULT_DITHER,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_NOISE_REDUCTION,
+      g_param_spec_boolean ("noise-reduction", "Noise reduction",
+          "Whether to subtract the tracked noise floor from the power "
+          "spectrum before the Mel filterbank", DEFAULT_NOISE_REDUCTION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_NOISE_OVERSUBTRACTION,
+      g_param_spec_float ("noise-oversubtraction", "Noise over-subtraction",
+          "Factor the noise floor estimate is scaled by before subtraction",
+          0.0, 10.0, DEFAULT_NOISE_OVERSUBTRACTION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SCORER_MODULE,
+      g_param_spec_string ("scorer-module", "Scorer module",
+          "Path of a scoring module fed with the feature frames "
+          "(takes effect on the next start)", DEFAULT_SCORER_MODULE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SCORER_OPTIONS,
+      g_param_spec_string ("scorer-options", "Scorer options",
+          "Option string passed to the scoring module", DEFAULT_SCORER_OPTIONS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SCORER_BATCH,
+      g_param_spec_uint ("scorer-batch", "Scorer batch",
+          "Number of feature frames handed to the scoring module at once",
+          1, 1024, DEFAULT_SCORER_BATCH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GMM_MODEL,
+      g_param_spec_string ("gmm-model", "GMM model",
+          "Path of a GMM classifier applied to every frame "
+          "(takes effect on the next start)", DEFAULT_GMM_MODEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GMM_SMOOTHING,
+      g_param_spec_uint ("gmm-smoothing", "GMM smoothing",
+          "Time constant in frames of the GMM decision smoothing",
+          1, 10000, DEFAULT_GMM_SMOOTHING,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_TEMPLATE_DIR,
+      g_param_spec_string ("template-dir", "Template directory",
+          "Directory of .dtw feature templates to detect in the stream "
+          "(takes effect on the next start)", DEFAULT_TEMPLATE_DIR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MATCH_THRESHOLD,
+      g_param_spec_float ("match-threshold", "Match threshold",
+          "Maximum mean frame distance of a template match",
+          0.0, G_MAXFLOAT, DEFAULT_MATCH_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FINGERPRINT,
+      g_param_spec_boolean ("fingerprint", "Fingerprint",
+          "Whether to post landmark fingerprint hashes for each interval",
+          DEFAULT_FINGERPRINT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PSD,
+      g_param_spec_boolean ("psd", "PSD",
+          "Whether to add the Welch power spectral density of each interval "
+          "to the messages", DEFAULT_PSD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PSD_DECIMATION,
+      g_param_spec_uint ("psd-decimation", "PSD decimation",
+          "Number of adjacent FFT bins averaged into each PSD value",
+          1, 4096, DEFAULT_PSD_DECIMATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CQT_BINS,
+      g_param_spec_uint ("cqt-bins", "Constant-Q bins",
+          "Number of constant-Q transform bins in the messages (0 = no CQT). "
+          "All octaves are taken from the full rate FFT, there is no "
+          "multi-octave decimation, so low bins are limited by window-size",
+          0, 1024, DEFAULT_CQT_BINS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CQT_BINS_PER_OCTAVE,
+      g_param_spec_uint ("cqt-bins-per-octave", "Constant-Q bins per octave",
+          "Number of constant-Q bins in each octave",
+          1, 96, DEFAULT_CQT_BINS_PER_OCTAVE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CQT_MIN_FREQ,
+      g_param_spec_float ("cqt-min-freq", "Constant-Q minimum frequency",
+          "Centre frequency of the lowest constant-Q bin in Hz",
+          1.0, G_MAXFLOAT, DEFAULT_CQT_MIN_FREQ,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ONSETS,
+      g_param_spec_boolean ("onsets", "Onsets",
+          "Whether to post a message for each detected onset",
+          DEFAULT_ONSETS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ONSET_THRESHOLD,
+      g_param_spec_float ("onset-threshold", "Onset threshold",
+          "Amount the spectral flux must exceed its running median by",
+          0.0, G_MAXFLOAT, DEFAULT_ONSET_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ONSET_WINDOW,
+      g_param_spec_uint ("onset-window", "Onset window",
+          "Number of past frames the median of the spectral flux is taken "
+          "over", 1, 1024, DEFAULT_ONSET_WINDOW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_LSH_INDEX,
+      g_param_spec_string ("lsh-index", "LSH index",
+          "Path of a random projection LSH index to query "
+          "(takes effect on the next start)", DEFAULT_LSH_INDEX,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_LSH_NUM_RESULTS,
+      g_param_spec_uint ("lsh-num-results", "LSH results",
+          "Number of nearest index entries reported per query",
+          1, 64, DEFAULT_LSH_NUM_RESULTS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_LSH_PER_FRAME,
+      g_param_spec_boolean ("lsh-per-frame", "LSH per frame",
+          "Query the LSH index for every frame instead of every interval",
+          DEFAULT_LSH_PER_FRAME, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_TDOA_PAIRS,
+      g_param_spec_string ("tdoa-pairs", "TDOA pairs",
+          "Comma separated channel pairs (e.g. \"0:1,0:2\") to estimate "
+          "GCC-PHAT delays for, requires multi-channel", DEFAULT_TDOA_PAIRS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_TDOA_MAX_DELAY,
+      g_param_spec_uint64 ("tdoa-max-delay", "TDOA maximum delay",
+          "Largest delay searched in nanoseconds (0 = half the FFT length)",
+          0, G_MAXUINT64, DEFAULT_TDOA_MAX_DELAY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_HISTORY_DURATION,
+      g_param_spec_uint64 ("history-duration", "History duration",
+          "Duration of recent feature frames kept for get-history "
+          "in nanoseconds (0 = disabled)", 0, G_MAXUINT64,
+          DEFAULT_HISTORY_DURATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MODULATION_FRAMES,
+      g_param_spec_uint ("modulation-frames", "Modulation frames",
+          "Frames of Mel band envelope in each modulation spectrum, rounded "
+          "up to an even number (0 = no modulation spectra)",
+          0, 8192, DEFAULT_MODULATION_FRAMES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_MODULATION_HOP,
+      g_param_spec_uint ("modulation-hop", "Modulation hop",
+          "Frames between modulation spectra (0 = modulation-frames)",
+          0, 8192, DEFAULT_MODULATION_HOP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ANALYSIS_THREADS,
+      g_param_spec_uint ("analysis-threads", "Analysis threads",
+          "Number of threads computing frame spectra (0 = one per CPU)",
+          0, 64, DEFAULT_ANALYSIS_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FFT_THREADS,
+      g_param_spec_uint ("fft-threads", "FFT threads",
+          "Number of threads running each FFT of at least "
+          G_STRINGIFY (FFT_THREADS_MIN_SIZE) " points (0 = one per CPU, "
+          "needs FFTW built with threads)",
+          0, 64, DEFAULT_FFT_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstCepstrum::new-features:
+   * @cepstrum: the #GstCepstrum
+   * @features: (type gpointer): @num_channels x @num_coeffs #gfloat
+   *   coefficients, only valid during the emission
+   * @num_channels: the number of channels in @features
+   * @num_coeffs: the number of coefficients per channel
+   * @timestamp: the timestamp of the frame
+   *
+   * Emitted from the streaming thread for every analysis frame when
+   * #GstCepstrum:emit-signals is %TRUE. The frames of a buffer are emitted
+   * once the whole buffer is analysed, without the element lock held, so
+   * handlers may set properties and pull #GstCepstrum::get-history, which
+   * then already holds the later frames of the same buffer.
+   */
+  gst_cepstrum_signals[SIGNAL_NEW_FEATURES] =
+      g_signal_new ("new-features", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST, 0, NULL, NULL, NULL, G_TYPE_NONE, 4,
+      G_TYPE_POINTER, G_TYPE_UINT, G_TYPE_UINT, G_TYPE_UINT64);
+
+  /**
+   * GstCepstrum::get-history:
+   * @cepstrum: the #GstCepstrum
+   * @duration: how much history to return in nanoseconds, 0 for all of it
+   *
+   * Pull the most recent feature frames kept because of
+   * #GstCepstrum:history-duration. The frames are packed oldest first as
+   * #gfloat arrays of the same layout as #GstCepstrum::new-features, the
+   * PTS of the buffer is the timestamp of the first frame and its duration
+   * spans up to the last one.
+   *
+   * Returns: (transfer full) (nullable): a #GstBuffer of frames, or %NULL if
+   * no frames are available.
+   */
+  gst_cepstrum_signals[SIGNAL_GET_HISTORY] =
+      g_signal_new ("get-history", G_TYPE_FROM_CLASS (klass),
+      G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION,
+      G_STRUCT_OFFSET (GstCepstrumClass, get_history), NULL, NULL, NULL,
+      GST_TYPE_BUFFER, 1, G_TYPE_UINT64);
+
+  klass->get_history = gst_cepstrum_get_history;
+
   GST_DEBUG_CATEGORY_INIT (gst_cepstrum_debug, "cepstrum", 0,
       "audio cepstrum analyser element");
 
@@ -216,136 +1021,1100 @@ static void
 gst_cepstrum_init (GstCepstrum * cepstrum)
 {
   cepstrum->post_messages = DEFAULT_POST_MESSAGES;
+  cepstrum->emit_signals = DEFAULT_EMIT_SIGNALS;
   cepstrum->multi_channel = DEFAULT_MULTI_CHANNEL;
   cepstrum->interval = DEFAULT_INTERVAL;
+  cepstrum->change_threshold = DEFAULT_CHANGE_THRESHOLD;
+  cepstrum->change_metric = DEFAULT_CHANGE_METRIC;
+  cepstrum->max_silence = DEFAULT_MAX_SILENCE;
   cepstrum->num_coeffs = DEFAULT_NUM_COEFFS;
-  cepstrum->num_filters = 2 * cepstrum->num_coeffs;
+  cepstrum->mel_filters = DEFAULT_NUM_FILTERS;
+  cepstrum->preset = DEFAULT_PRESET;
+  cepstrum->feature_type = DEFAULT_FEATURE_TYPE;
+  cepstrum->snip_edges = DEFAULT_SNIP_EDGES;
+  cepstrum->window_type = DEFAULT_WINDOW_TYPE;
+  cepstrum->mel_scale = DEFAULT_MEL_SCALE;
+  cepstrum->mel_norm = DEFAULT_MEL_NORM;
+  cepstrum->energy_floor = DEFAULT_ENERGY_FLOOR;
+  cepstrum->lifter = DEFAULT_LIFTER;
+  cepstrum->dither = DEFAULT_DITHER;
   cepstrum->sample_rate = DEFAULT_SAMPLE_RATE;
+  cepstrum->sample_scale = 32768.0;
   cepstrum->fft_size = DEFAULT_FFT_SIZE;
   cepstrum->win_size = DEFAULT_WINDOW_SIZE;
   cepstrum->hop_size = DEFAULT_HOP_SIZE;
+  cepstrum->dft_mode = DEFAULT_DFT_MODE;
+  cepstrum->low_freq = DEFAULT_LOW_FREQ;
+  cepstrum->high_freq = DEFAULT_HIGH_FREQ;
   cepstrum->use_preemphasis = DEFAULT_USE_PREEMPHASIS;
   cepstrum->preemphasis_coeff = DEFAULT_PREEMPHASIS_COEFF;
+  cepstrum->remove_dc = DEFAULT_REMOVE_DC;
+  cepstrum->scorer_module = g_strdup (DEFAULT_SCORER_MODULE);
+  cepstrum->scorer_options = g_strdup (DEFAULT_SCORER_OPTIONS);
+  cepstrum->scorer_batch = DEFAULT_SCORER_BATCH;
+  cepstrum->gmm_model = g_strdup (DEFAULT_GMM_MODEL);
+  cepstrum->gmm_smoothing = DEFAULT_GMM_SMOOTHING;
+  cepstrum->template_dir = g_strdup (DEFAULT_TEMPLATE_DIR);
+  cepstrum->match_threshold = DEFAULT_MATCH_THRESHOLD;
+  cepstrum->fingerprint = DEFAULT_FINGERPRINT;
+  cepstrum->psd = DEFAULT_PSD;
+  cepstrum->psd_decimation = DEFAULT_PSD_DECIMATION;
+  cepstrum->cqt_bins = DEFAULT_CQT_BINS;
+  cepstrum->cqt_bins_per_octave = DEFAULT_CQT_BINS_PER_OCTAVE;
+  cepstrum->cqt_min_freq = DEFAULT_CQT_MIN_FREQ;
+  cepstrum->onsets = DEFAULT_ONSETS;
+  cepstrum->noise_reduction = DEFAULT_NOISE_REDUCTION;
+  cepstrum->noise_oversubtraction = DEFAULT_NOISE_OVERSUBTRACTION;
+  cepstrum->onset_threshold = DEFAULT_ONSET_THRESHOLD;
+  cepstrum->onset_window = DEFAULT_ONSET_WINDOW;
+  cepstrum->lsh_index = g_strdup (DEFAULT_LSH_INDEX);
+  cepstrum->lsh_num_results = DEFAULT_LSH_NUM_RESULTS;
+  cepstrum->lsh_per_frame = DEFAULT_LSH_PER_FRAME;
+  cepstrum->tdoa_pairs = g_strdup (DEFAULT_TDOA_PAIRS);
+  cepstrum->tdoa_max_delay = DEFAULT_TDOA_MAX_DELAY;
+  cepstrum->modulation_frames = DEFAULT_MODULATION_FRAMES;
+  cepstrum->modulation_hop = DEFAULT_MODULATION_HOP;
+  cepstrum->history_duration = DEFAULT_HISTORY_DURATION;
+  cepstrum->analysis_threads = DEFAULT_ANALYSIS_THREADS;
+  cepstrum->fft_threads = DEFAULT_FFT_THREADS;
 
   g_mutex_init (&cepstrum->lock);
+  g_mutex_init (&cepstrum->jobs_lock);
+  cepstrum->signal_features = g_array_new (FALSE, FALSE, sizeof (gfloat));
+  cepstrum->signal_ts = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  g_cond_init (&cepstrum->jobs_cond);
 }
 
-static void
-gst_cepstrum_alloc_channel_data (GstCepstrum * cepstrum)
+static gboolean
+gst_cepstrum_scorer_load (GstCepstrum * cepstrum)
 {
-  gint i;
-  GstCepstrumChannel *cd;
-  guint fft_size = cepstrum->fft_size;
-  guint num_coeffs = cepstrum->num_coeffs;
-  guint nfilts = cepstrum->num_filters;
-  guint nfft = 2 * fft_size - 2;
-  guint sample_rate = cepstrum->sample_rate;
-
-  g_assert (cepstrum->channel_data == NULL);
+  GstCepstrumScorerGetInfo get_info;
+  const GstCepstrumScorerInfo *info;
+
+  if (cepstrum->scorer_module == NULL || *cepstrum->scorer_module == '\0')
+    return TRUE;
+
+  cepstrum->scorer = g_module_open (cepstrum->scorer_module,
+      G_MODULE_BIND_LAZY | G_MODULE_BIND_LOCAL);
+  if (cepstrum->scorer == NULL) {
+    GST_ELEMENT_ERROR (cepstrum, RESOURCE, OPEN_READ,
+        ("Could not load scorer module %s", cepstrum->scorer_module),
+        ("%s", g_module_error ()));
+    return FALSE;
+  }
 
-  cepstrum->num_channels = (cepstrum->multi_channel) ?
-      GST_AUDIO_FILTER_CHANNELS (cepstrum) : 1;
+  if (!g_module_symbol (cepstrum->scorer, GST_CEPSTRUM_SCORER_SYMBOL,
+          (gpointer *) & get_info) || get_info == NULL ||
+      (info = get_info ()) == NULL) {
+    GST_ELEMENT_ERROR (cepstrum, LIBRARY, INIT,
+        ("Invalid scorer module %s", cepstrum->scorer_module),
+        ("missing symbol %s", GST_CEPSTRUM_SCORER_SYMBOL));
+    goto error;
+  }
 
-  GST_DEBUG_OBJECT (cepstrum, "allocating data for %d channels",
-      cepstrum->num_channels);
+  if (info->abi_version != GST_CEPSTRUM_SCORER_ABI_VERSION ||
+      info->open == NULL || info->score == NULL || info->close == NULL) {
+    GST_ELEMENT_ERROR (cepstrum, LIBRARY, INIT,
+        ("Invalid scorer module %s", cepstrum->scorer_module),
+        ("unsupported ABI version %u", info->abi_version));
+    goto error;
+  }
 
-  cepstrum->channel_data = g_new (GstCepstrumChannel, cepstrum->num_channels);
-  cepstrum->filter_bank = g_malloc0 (sizeof (gfloat*) * nfilts);
-  alloc_mel_filterbank (cepstrum->filter_bank, nfilts, sample_rate, nfft);
+  GST_INFO_OBJECT (cepstrum, "loaded scorer '%s' from %s",
+      GST_STR_NULL (info->name), cepstrum->scorer_module);
+  cepstrum->scorer_info = info;
 
-  for (i = 0; i < cepstrum->num_channels; i++) {
-    cd = &cepstrum->channel_data[i];
-    cd->input = g_new0 (gfloat, nfft);
-#ifdef HAVE_LIBFFTW
-    cd->input_tmp = (gfloat*) fftw_malloc(sizeof(gfloat) * nfft);
-    cd->fftdata = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * nfft);
-    cd->fftplan = fftw_plan_dft_r2c_1d(nfft, (double *) cd->input_tmp,
-                        cd->fftdata, FFTW_ESTIMATE);
-#else
-    cd->fft_ctx = gst_fft_f32_new (nfft, FALSE);
-    cd->input_tmp = g_new0 (gfloat, nfft);
-    cd->fftdata = g_new0 (GstFFTF32Complex, fft_size);
-#endif
-    cd->spect_magnitude = g_new0 (gfloat, fft_size);
-    cd->mfcc = g_new0 (gfloat, num_coeffs);
-  }
+  return TRUE;
 
-  GST_DEBUG_OBJECT (cepstrum, "fft_size %d", fft_size);
+error:
+  g_module_close (cepstrum->scorer);
+  cepstrum->scorer = NULL;
+  return FALSE;
+}
 
+static void
+gst_cepstrum_scorer_unload (GstCepstrum * cepstrum)
+{
+  cepstrum->scorer_info = NULL;
+  if (cepstrum->scorer) {
+    g_module_close (cepstrum->scorer);
+    cepstrum->scorer = NULL;
+  }
 }
 
 static void
-gst_cepstrum_free_channel_data (GstCepstrum * cepstrum)
+gst_cepstrum_scorer_open (GstCepstrum * cepstrum)
 {
-  if (cepstrum->channel_data) {
-    gint i;
-    GstCepstrumChannel *cd;
+  GstCepstrumScorerConfig config;
+  guint num_outputs = 0;
+
+  g_assert (cepstrum->scorer_handle == NULL);
+
+  config.frame_len = cepstrum->frame_len;
+  config.num_channels = cepstrum->num_channels;
+  config.num_coeffs = cepstrum->num_coeffs;
+  config.max_frames = cepstrum->scorer_batch;
+  config.sample_rate = GST_AUDIO_FILTER_RATE (cepstrum);
+  config.options = cepstrum->scorer_options;
+
+  cepstrum->scorer_handle = cepstrum->scorer_info->open (&config,
+      &num_outputs);
+  if (cepstrum->scorer_handle == NULL || num_outputs == 0) {
+    GST_WARNING_OBJECT (cepstrum, "scorer failed to open, scoring disabled");
+    if (cepstrum->scorer_handle)
+      cepstrum->scorer_info->close (cepstrum->scorer_handle);
+    cepstrum->scorer_handle = NULL;
+    return;
+  }
 
-    GST_DEBUG_OBJECT (cepstrum, "freeing data for %d channels",
-        cepstrum->num_channels);
+  cepstrum->scorer_num_outputs = num_outputs;
+  cepstrum->scorer_frames =
+      g_new0 (gfloat, cepstrum->scorer_batch * cepstrum->frame_len);
+  cepstrum->scorer_scores = g_new0 (gfloat, cepstrum->scorer_batch *
+      num_outputs);
+  cepstrum->scorer_pending = 0;
+}
 
-    for (i = 0; i < cepstrum->num_channels; i++) {
-      cd = &cepstrum->channel_data[i];
-  #ifdef HAVE_LIBFFTW
-      if (cd->fftplan)
-        fftw_destroy_plan(cd->fftplan);
-      if (cd->fftdata)
-        fftw_free(cd->fftdata);
-  #else
-      if (cd->fft_ctx)
-        gst_fft_f32_free (cd->fft_ctx);
-      g_free (cd->fftdata);
-  #endif
-      g_free (cd->input);
-      g_free (cd->input_tmp);
-      g_free (cd->mfcc);
-      g_free (cd->spect_magnitude);
-    }
-    free_mel_filterbank (cepstrum->filter_bank, cepstrum->num_filters);
-    g_free (cepstrum->filter_bank);
-    g_free (cepstrum->channel_data);
-    cepstrum->channel_data = NULL;
+static void
+gst_cepstrum_scorer_close (GstCepstrum * cepstrum)
+{
+  if (cepstrum->scorer_handle) {
+    cepstrum->scorer_info->close (cepstrum->scorer_handle);
+    cepstrum->scorer_handle = NULL;
   }
+  g_free (cepstrum->scorer_frames);
+  cepstrum->scorer_frames = NULL;
+  g_free (cepstrum->scorer_scores);
+  cepstrum->scorer_scores = NULL;
+  cepstrum->scorer_pending = 0;
 }
 
-static void
-gst_cepstrum_flush (GstCepstrum * cepstrum)
+static gboolean
+gst_cepstrum_gmm_load_model (GstCepstrum * cepstrum)
 {
-  cepstrum->num_frames = 0;
-  cepstrum->num_fft = 0;
+  GError *err = NULL;
+  guint num_classes;
+
+  if (cepstrum->gmm_model == NULL || *cepstrum->gmm_model == '\0')
+    return TRUE;
+
+  cepstrum->gmm = gst_cepstrum_gmm_load (cepstrum->gmm_model, &err);
+  if (cepstrum->gmm == NULL) {
+    GST_ELEMENT_ERROR (cepstrum, RESOURCE, OPEN_READ,
+        ("Could not load GMM model %s", cepstrum->gmm_model),
+        ("%s", err->message));
+    g_error_free (err);
+    return FALSE;
+  }
 
-  cepstrum->accumulated_error = 0;
+  num_classes = gst_cepstrum_gmm_get_num_classes (cepstrum->gmm);
+  cepstrum->gmm_loglik = g_new0 (gfloat, num_classes);
+  cepstrum->gmm_smoothed = g_new0 (gfloat, num_classes);
+
+  GST_INFO_OBJECT (cepstrum, "loaded GMM with %u classes, dim %u",
+      num_classes, gst_cepstrum_gmm_get_dim (cepstrum->gmm));
+
+  return TRUE;
 }
 
 static void
-gst_cepstrum_reset_state (GstCepstrum * cepstrum)
+gst_cepstrum_gmm_unload_model (GstCepstrum * cepstrum)
 {
-  GST_DEBUG_OBJECT (cepstrum, "resetting state");
+  gst_cepstrum_gmm_free (cepstrum->gmm);
+  cepstrum->gmm = NULL;
+  cepstrum->gmm_active = FALSE;
+  g_free (cepstrum->gmm_loglik);
+  cepstrum->gmm_loglik = NULL;
+  g_free (cepstrum->gmm_smoothed);
+  cepstrum->gmm_smoothed = NULL;
+}
 
-  gst_cepstrum_free_channel_data (cepstrum);
-  gst_cepstrum_flush (cepstrum);
+static gboolean
+gst_cepstrum_dtw_load_templates (GstCepstrum * cepstrum)
+{
+  GError *err = NULL;
+  guint num_loaded;
+
+  if (cepstrum->template_dir == NULL || *cepstrum->template_dir == '\0')
+    return TRUE;
+
+  cepstrum->dtw = gst_cepstrum_dtw_new ();
+  num_loaded = gst_cepstrum_dtw_add_template_dir (cepstrum->dtw,
+      cepstrum->template_dir, &err);
+
+  if (num_loaded == 0) {
+    GST_ELEMENT_ERROR (cepstrum, RESOURCE, OPEN_READ,
+        ("Could not load templates from %s", cepstrum->template_dir),
+        ("%s", err ? err->message : "no template found"));
+    g_clear_error (&err);
+    gst_cepstrum_dtw_free (cepstrum->dtw);
+    cepstrum->dtw = NULL;
+    return FALSE;
+  }
+
+  if (err) {
+    GST_WARNING_OBJECT (cepstrum, "skipped template: %s", err->message);
+    g_error_free (err);
+  }
+
+  GST_INFO_OBJECT (cepstrum, "loaded %u templates, dim %u", num_loaded,
+      gst_cepstrum_dtw_get_dim (cepstrum->dtw));
+
+  return TRUE;
 }
 
 static void
-gst_cepstrum_finalize (GObject * object)
+gst_cepstrum_dtw_unload_templates (GstCepstrum * cepstrum)
 {
-  GstCepstrum *cepstrum = GST_CEPSTRUM (object);
+  gst_cepstrum_dtw_free (cepstrum->dtw);
+  cepstrum->dtw = NULL;
+  cepstrum->dtw_active = FALSE;
+}
 
-  gst_cepstrum_reset_state (cepstrum);
-  g_mutex_clear (&cepstrum->lock);
+static gboolean
+gst_cepstrum_lsh_open_index (GstCepstrum * cepstrum)
+{
+  GError *err = NULL;
+
+  if (cepstrum->lsh_index == NULL || *cepstrum->lsh_index == '\0')
+    return TRUE;
+
+  cepstrum->lsh = gst_cepstrum_lsh_open (cepstrum->lsh_index, &err);
+  if (cepstrum->lsh == NULL) {
+    GST_ELEMENT_ERROR (cepstrum, RESOURCE, OPEN_READ,
+        ("Could not open LSH index %s", cepstrum->lsh_index),
+        ("%s", err->message));
+    g_error_free (err);
+    return FALSE;
+  }
 
-  G_OBJECT_CLASS (parent_class)->finalize (object);
+  GST_INFO_OBJECT (cepstrum, "mapped LSH index with %" G_GUINT64_FORMAT
+      " entries, dim %u", gst_cepstrum_lsh_get_num_entries (cepstrum->lsh),
+      gst_cepstrum_lsh_get_dim (cepstrum->lsh));
+
+  return TRUE;
 }
 
 static void
-gst_cepstrum_set_property (GObject * object, guint prop_id,
-    const GValue * value, GParamSpec * pspec)
+gst_cepstrum_lsh_close_index (GstCepstrum * cepstrum)
 {
-  GstCepstrum *filter = GST_CEPSTRUM (object);
+  gst_cepstrum_lsh_close (cepstrum->lsh);
+  cepstrum->lsh = NULL;
+  cepstrum->lsh_active = FALSE;
+}
 
-  switch (prop_id) {
-    case PROP_POST_MESSAGES:
-      filter->post_messages = g_value_get_boolean (value);
+#ifdef HAVE_LIBFFTW
+/* the FFTW planner is not thread safe and its thread count is global, so
+ * all instances plan and destroy plans under this lock */
+G_LOCK_DEFINE_STATIC (fftw_planner);
+
+/* set the number of threads the next plan of @nfft points runs on; FFTW
+ * keeps its worker threads in one pool shared by all plans. Call with the
+ * planner lock held */
+static void
+gst_cepstrum_fftw_plan_threads (GstCepstrum * cepstrum, guint nfft)
+{
+#ifdef HAVE_LIBFFTW_THREADS
+  static gsize threads_init = 0;
+  guint nthreads = 1;
+
+  if (g_once_init_enter (&threads_init))
+    g_once_init_leave (&threads_init, fftw_init_threads () ? 1 : 2);
+
+  if (threads_init == 1 && nfft >= FFT_THREADS_MIN_SIZE)
+    nthreads = cepstrum->fft_threads ?
+        cepstrum->fft_threads : g_get_num_processors ();
+  GST_DEBUG_OBJECT (cepstrum, "planning %u point FFT for %u threads", nfft,
+      nthreads);
+  fftw_plan_with_nthreads (nthreads);
+#endif
+}
+#endif
+
+static void
+gst_cepstrum_tdoa_alloc (GstCepstrum * cepstrum, guint fft_size)
+{
+  guint nfft = 2 * fft_size - 2;
+  gchar **pairs;
+  guint i, n = 0;
+
+  if (cepstrum->tdoa_pairs == NULL || *cepstrum->tdoa_pairs == '\0')
+    return;
+
+  if (!cepstrum->multi_channel) {
+    GST_WARNING_OBJECT (cepstrum, "tdoa-pairs requires multi-channel");
+    return;
+  }
+
+  pairs = g_strsplit (cepstrum->tdoa_pairs, ",", -1);
+  cepstrum->tdoa_channels = g_new0 (guint, 2 * g_strv_length (pairs));
+  for (i = 0; pairs[i] != NULL; i++) {
+    guint a, b;
+
+    if (sscanf (pairs[i], "%u:%u", &a, &b) != 2 || a == b ||
+        a >= cepstrum->num_channels || b >= cepstrum->num_channels) {
+      GST_WARNING_OBJECT (cepstrum, "ignoring invalid channel pair '%s'",
+          pairs[i]);
+      continue;
+    }
+    cepstrum->tdoa_channels[2 * n] = a;
+    cepstrum->tdoa_channels[2 * n + 1] = b;
+    n++;
+  }
+  g_strfreev (pairs);
+
+  cepstrum->tdoa_num_pairs = n;
+  if (n == 0) {
+    g_free (cepstrum->tdoa_channels);
+    cepstrum->tdoa_channels = NULL;
+    return;
+  }
+
+  cepstrum->tdoa_delays = g_new0 (gfloat, n);
+#ifdef HAVE_LIBFFTW
+  cepstrum->tdoa_cross =
+      (fftw_complex *) fftw_malloc (sizeof (fftw_complex) * fft_size);
+  cepstrum->tdoa_corr = (gdouble *) fftw_malloc (sizeof (gdouble) * nfft);
+  G_LOCK (fftw_planner);
+  gst_cepstrum_fftw_plan_threads (cepstrum, nfft);
+  cepstrum->tdoa_plan = fftw_plan_dft_c2r_1d (nfft, cepstrum->tdoa_cross,
+      cepstrum->tdoa_corr, FFTW_ESTIMATE);
+  G_UNLOCK (fftw_planner);
+#else
+  cepstrum->tdoa_cross = g_new0 (GstFFTF32Complex, fft_size);
+  cepstrum->tdoa_corr = g_new0 (gfloat, nfft);
+  cepstrum->tdoa_ctx = gst_fft_f32_new (nfft, TRUE);
+#endif
+}
+
+static void
+gst_cepstrum_tdoa_free (GstCepstrum * cepstrum)
+{
+  if (cepstrum->tdoa_num_pairs == 0)
+    return;
+
+#ifdef HAVE_LIBFFTW
+  G_LOCK (fftw_planner);
+  fftw_destroy_plan (cepstrum->tdoa_plan);
+  G_UNLOCK (fftw_planner);
+  fftw_free (cepstrum->tdoa_cross);
+  fftw_free (cepstrum->tdoa_corr);
+#else
+  gst_fft_f32_free (cepstrum->tdoa_ctx);
+  g_free (cepstrum->tdoa_cross);
+  g_free (cepstrum->tdoa_corr);
+#endif
+  g_free (cepstrum->tdoa_channels);
+  cepstrum->tdoa_channels = NULL;
+  g_free (cepstrum->tdoa_delays);
+  cepstrum->tdoa_delays = NULL;
+  cepstrum->tdoa_num_pairs = 0;
+}
+
+/* envelope rings of the @num_bands Mel bands and the batched transform of
+ * their modulation spectra */
+static void
+gst_cepstrum_modulation_alloc (GstCepstrum * cepstrum, guint num_bands)
+{
+  guint len = GST_ROUND_UP_2 (cepstrum->modulation_frames);
+#ifdef HAVE_LIBFFTW
+  gint n = len;
+#endif
+
+  if (len == 0)
+    return;
+
+  cepstrum->mod_len = len;
+  cepstrum->mod_bins = len / 2 + 1;
+  cepstrum->mod_history = g_new0 (gfloat, (gsize) num_bands * len);
+  cepstrum->mod_window = g_new (gfloat, len);
+  compute_window (cepstrum->mod_window, len, GST_CEPSTRUM_WINDOW_HANN);
+  cepstrum->mod_power = g_new0 (gfloat, (gsize) num_bands * cepstrum->mod_bins);
+#ifdef HAVE_LIBFFTW
+  cepstrum->mod_in =
+      (gdouble *) fftw_malloc (sizeof (gdouble) * num_bands * len);
+  cepstrum->mod_out = (fftw_complex *) fftw_malloc (sizeof (fftw_complex) *
+      num_bands * cepstrum->mod_bins);
+  G_LOCK (fftw_planner);
+  gst_cepstrum_fftw_plan_threads (cepstrum, len);
+  cepstrum->mod_plan = fftw_plan_many_dft_r2c (1, &n,
+      num_bands, cepstrum->mod_in, NULL, 1, len, cepstrum->mod_out, NULL, 1,
+      cepstrum->mod_bins, FFTW_ESTIMATE);
+  G_UNLOCK (fftw_planner);
+#else
+  cepstrum->mod_in = g_new0 (gfloat, (gsize) num_bands * len);
+  cepstrum->mod_out = g_new0 (GstFFTF32Complex,
+      (gsize) num_bands * cepstrum->mod_bins);
+  cepstrum->mod_ctx = gst_fft_f32_new (len, FALSE);
+#endif
+}
+
+static void
+gst_cepstrum_modulation_free (GstCepstrum * cepstrum)
+{
+  if (cepstrum->mod_len == 0)
+    return;
+
+#ifdef HAVE_LIBFFTW
+  G_LOCK (fftw_planner);
+  fftw_destroy_plan (cepstrum->mod_plan);
+  G_UNLOCK (fftw_planner);
+  fftw_free (cepstrum->mod_in);
+  fftw_free (cepstrum->mod_out);
+#else
+  gst_fft_f32_free (cepstrum->mod_ctx);
+  g_free (cepstrum->mod_in);
+  g_free (cepstrum->mod_out);
+#endif
+  g_free (cepstrum->mod_history);
+  cepstrum->mod_history = NULL;
+  g_free (cepstrum->mod_window);
+  cepstrum->mod_window = NULL;
+  g_free (cepstrum->mod_power);
+  cepstrum->mod_power = NULL;
+  cepstrum->mod_len = 0;
+}
+
+/* divisor turning squared FFT magnitudes into the power spectrum, the two
+ * FFT backends scale their output differently */
+static inline gdouble
+gst_cepstrum_power_scale (guint nfft)
+{
+#ifdef HAVE_LIBFFTW
+  return nfft;
+#else
+  return (gdouble) nfft * nfft;
+#endif
+}
+
+/* whether frame spectra should come from a sliding DFT over the @num_bins
+ * @bins the filterbank uses instead of an FFT per frame */
+static gboolean
+gst_cepstrum_choose_sdft (GstCepstrum * cepstrum, guint nfft, guint num_bins)
+{
+  gdouble fft_cost, sdft_cost;
+
+  if (cepstrum->dft_mode == GST_CEPSTRUM_DFT_MODE_FFT || num_bins == 0)
+    return FALSE;
+
+  /* the sliding DFT applies a Hamming window in the frequency domain */
+  if (cepstrum->window_type != GST_CEPSTRUM_WINDOW_HAMMING) {
+    if (cepstrum->dft_mode == GST_CEPSTRUM_DFT_MODE_SLIDING)
+      GST_WARNING_OBJECT (cepstrum, "sliding DFT only supports the Hamming "
+          "window, using the FFT");
+    return FALSE;
+  }
+
+  /* these need the complete spectrum of every frame */
+  if (cepstrum->tdoa_num_pairs || cepstrum->fingerprint ||
+      cepstrum->cqt_bins || cepstrum->psd) {
+    if (cepstrum->dft_mode == GST_CEPSTRUM_DFT_MODE_SLIDING)
+      GST_WARNING_OBJECT (cepstrum, "sliding DFT not possible with "
+          "fingerprints, the PSD, the CQT or TDOA, using the FFT");
+    return FALSE;
+  }
+
+  /* the presets pre-filter every frame on its own */
+  if (cepstrum->preset != GST_CEPSTRUM_PRESET_NONE) {
+    if (cepstrum->dft_mode == GST_CEPSTRUM_DFT_MODE_SLIDING)
+      GST_WARNING_OBJECT (cepstrum, "sliding DFT not possible with a "
+          "preset, using the FFT");
+    return FALSE;
+  }
+
+  if (cepstrum->dft_mode == GST_CEPSTRUM_DFT_MODE_SLIDING)
+    return TRUE;
+
+  /* a real FFT is roughly 2.5 N log2 N, plus windowing the frame */
+  fft_cost = 2.5 * nfft * log2 (nfft) + 2.0 * cepstrum->win_len;
+  sdft_cost = gst_cepstrum_sdft_cost (num_bins, cepstrum->hop_len);
+
+  GST_DEBUG_OBJECT (cepstrum, "FFT cost %f, sliding DFT cost %f", fft_cost,
+      sdft_cost);
+
+  return sdft_cost < fft_cost;
+}
+
+static void
+gst_cepstrum_alloc_channel_data (GstCepstrum * cepstrum)
+{
+  gint i;
+  GstCepstrumChannel *cd;
+  guint fft_size = cepstrum->fft_size;
+  guint num_coeffs = cepstrum->num_coeffs;
+  guint nfilts;
+  guint nfft = 2 * fft_size - 2;
+  guint rate = GST_AUDIO_FILTER_RATE (cepstrum);
+  guint num_slots, slot_stride, spectrum_stride;
+  guint *bins, num_bins = 0, num_power_bins;
+  gsize slot_size;
+  gfloat low_freq, high_freq;
+  gdouble gain;
+  gboolean pncc;
+
+  g_assert (cepstrum->channel_data == NULL);
+
+  nfilts = cepstrum->num_filters = cepstrum->mel_filters ?
+      cepstrum->mel_filters : 2 * num_coeffs;
+
+  cepstrum->win_len = cepstrum->win_size > 0 ?
+      MIN ((guint) cepstrum->win_size, nfft) : nfft;
+  cepstrum->hop_len = cepstrum->hop_size > 0 ?
+      (guint) cepstrum->hop_size : cepstrum->win_len;
+
+  cepstrum->num_channels = (cepstrum->multi_channel) ?
+      GST_AUDIO_FILTER_CHANNELS (cepstrum) : 1;
+
+  GST_DEBUG_OBJECT (cepstrum, "allocating data for %d channels",
+      cepstrum->num_channels);
+
+  cepstrum->channel_data = g_new (GstCepstrumChannel, cepstrum->num_channels);
+
+  /* the band and the bins it maps to follow the rate of the caps */
+  high_freq = rate / 2.0;
+  if (cepstrum->high_freq > 0.0 && cepstrum->high_freq < high_freq)
+    high_freq = cepstrum->high_freq;
+  low_freq = cepstrum->low_freq;
+  if (low_freq >= high_freq) {
+    GST_WARNING_OBJECT (cepstrum, "low-freq %f not below the upper edge %f, "
+        "using 0", low_freq, high_freq);
+    low_freq = 0.0;
+  }
+
+  /* the toolkits take the unscaled power spectrum, HTK and Kaldi of the 16
+   * bit sample values, so their energy floors apply as they are */
+  pncc = (cepstrum->feature_type == GST_CEPSTRUM_FEATURE_TYPE_PNCC);
+  gain = 1.0;
+  if (cepstrum->preset != GST_CEPSTRUM_PRESET_NONE)
+    gain = gst_cepstrum_power_scale (nfft);
+  if (cepstrum->preset == GST_CEPSTRUM_PRESET_HTK ||
+      cepstrum->preset == GST_CEPSTRUM_PRESET_KALDI)
+    gain *= cepstrum->sample_scale * cepstrum->sample_scale;
+  /* HTK's default USEPOWER=F applies the filterbank to the magnitude */
+  if (cepstrum->preset == GST_CEPSTRUM_PRESET_HTK && !pncc)
+    gain = sqrt (gain);
+
+  cepstrum->filter_bank = g_new0 (GstCepstrumMelFilter, nfilts);
+  if (pncc)
+    alloc_gammatone_filterbank (cepstrum->filter_bank, nfilts, rate, nfft,
+        low_freq, high_freq, gain);
+  else
+    alloc_mel_filterbank (cepstrum->filter_bank, nfilts, rate, nfft,
+        low_freq, high_freq, cepstrum->mel_scale, cepstrum->mel_norm,
+        cepstrum->preset, gain);
+
+  cepstrum->window = g_new (gfloat, cepstrum->win_len);
+  compute_window (cepstrum->window, cepstrum->win_len,
+      cepstrum->window_type);
+  cepstrum->dct = g_new (gfloat, (gsize) num_coeffs * nfilts);
+  compute_dct_matrix (cepstrum->dct, nfilts, num_coeffs, cepstrum->lifter,
+      pncc ? GST_CEPSTRUM_PRESET_NONE : cepstrum->preset);
+
+  /* only the bins the filterbank covers are needed, unless the fingerprints
+   * or the PSD look at the complete power spectrum */
+  cepstrum->bin_lo = G_MAXUINT;
+  cepstrum->bin_hi = 0;
+  for (guint f = 0; f < nfilts; f++) {
+    GstCepstrumMelFilter *filter = &cepstrum->filter_bank[f];
+
+    cepstrum->bin_lo = MIN (cepstrum->bin_lo, filter->start);
+    cepstrum->bin_hi = MAX (cepstrum->bin_hi, filter->start + filter->len);
+  }
+  if (cepstrum->fingerprint || cepstrum->psd) {
+    cepstrum->bin_lo = 0;
+    cepstrum->bin_hi = fft_size;
+  }
+  cepstrum->bin_hi = MAX (MIN (cepstrum->bin_hi, fft_size),
+      cepstrum->bin_lo);
+  num_power_bins = cepstrum->bin_hi - cepstrum->bin_lo;
+
+  /* power spectra only store the bins from bin_lo on */
+  for (guint f = 0; f < nfilts; f++)
+    cepstrum->filter_bank[f].start -= cepstrum->bin_lo;
+
+  gst_cepstrum_tdoa_alloc (cepstrum, fft_size);
+
+  gst_cepstrum_modulation_alloc (cepstrum, nfilts);
+
+  cepstrum->num_psd = 0;
+  if (cepstrum->psd) {
+    cepstrum->num_psd = (fft_size + cepstrum->psd_decimation - 1) /
+        cepstrum->psd_decimation;
+    cepstrum->psd_norm = 0.0;
+    for (guint n = 0; n < cepstrum->win_len; n++)
+      cepstrum->psd_norm += cepstrum->window[n] * cepstrum->window[n];
+  }
+
+  cepstrum->num_cqt = 0;
+  if (cepstrum->cqt_bins)
+    cepstrum->num_cqt = alloc_cqt_kernels (cepstrum, nfft);
+
+  /* bins any filter of the bank picks up */
+  bins = g_new (guint, MAX (num_power_bins, 1));
+  for (guint j = 0; j < num_power_bins; j++) {
+    for (guint f = 0; f < nfilts; f++) {
+      GstCepstrumMelFilter *filter = &cepstrum->filter_bank[f];
+
+      if (j >= filter->start && j < filter->start + filter->len &&
+          filter->weights[j - filter->start] != 0.0f) {
+        bins[num_bins++] = cepstrum->bin_lo + j;
+        break;
+      }
+    }
+  }
+  cepstrum->use_sdft = gst_cepstrum_choose_sdft (cepstrum, nfft, num_bins);
+  GST_DEBUG_OBJECT (cepstrum, "window %u, hop %u, %s over %u bins, power "
+      "of bins %u to %u", cepstrum->win_len, cepstrum->hop_len,
+      cepstrum->use_sdft ? "sliding DFT" : "FFT", num_bins, cepstrum->bin_lo,
+      cepstrum->bin_hi);
+
+  /* keep every slot aligned for the SIMD code of the FFT; the window is
+   * zero padded to nfft in fftin, or in input_tmp for the GStreamer FFT */
+#ifdef HAVE_LIBFFTW
+  slot_stride = GST_ROUND_UP_16 (cepstrum->win_len);
+  cepstrum->fftin_stride = GST_ROUND_UP_16 (nfft);
+#else
+  slot_stride = GST_ROUND_UP_16 (nfft);
+#endif
+  spectrum_stride = GST_ROUND_UP_4 (fft_size);
+
+  /* large windows limit the batch so its buffers stay within
+   * BATCH_MAX_BYTES, but every thread gets at least one frame */
+  slot_size = sizeof (gfloat) * (slot_stride + num_power_bins) +
+      sizeof (cd->fftdata[0]) * spectrum_stride;
+#ifdef HAVE_LIBFFTW
+  slot_size += sizeof (gdouble) * cepstrum->fftin_stride;
+#endif
+  slot_size *= cepstrum->num_channels;
+
+  cepstrum->num_threads = cepstrum->analysis_threads ?
+      cepstrum->analysis_threads : g_get_num_processors ();
+  num_slots = 1;
+  if (cepstrum->num_threads > 1)
+    num_slots = CLAMP (BATCH_MAX_BYTES / slot_size, cepstrum->num_threads,
+        cepstrum->num_threads * FRAMES_PER_THREAD);
+  cepstrum->num_slots = num_slots;
+  cepstrum->slot_stride = slot_stride;
+  cepstrum->spectrum_stride = spectrum_stride;
+
+  for (i = 0; i < cepstrum->num_channels; i++) {
+    cd = &cepstrum->channel_data[i];
+    cd->input = g_new0 (gfloat, cepstrum->win_len);
+    cd->input_tmp = g_new0 (gfloat, (gsize) num_slots * slot_stride);
+#ifdef HAVE_LIBFFTW
+    cd->fftin = (gdouble*) fftw_malloc(sizeof(gdouble) *
+                        num_slots * cepstrum->fftin_stride);
+    /* the padding after the window stays zero */
+    memset (cd->fftin, 0, sizeof (gdouble) * num_slots *
+        cepstrum->fftin_stride);
+    cd->fftdata = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) *
+                        num_slots * spectrum_stride);
+    G_LOCK (fftw_planner);
+    gst_cepstrum_fftw_plan_threads (cepstrum, nfft);
+    cd->fftplan = fftw_plan_dft_r2c_1d(nfft, cd->fftin,
+                        cd->fftdata, FFTW_ESTIMATE);
+    G_UNLOCK (fftw_planner);
+#else
+    cd->fft_ctx = g_new0 (GstFFTF32 *, num_slots);
+    for (guint j = 0; j < num_slots; j++)
+      cd->fft_ctx[j] = gst_fft_f32_new (nfft, FALSE);
+    cd->fftdata = g_new0 (GstFFTF32Complex,
+        (gsize) num_slots * spectrum_stride);
+#endif
+    cd->spectrum = cd->fftdata;
+    cd->spect_magnitude = g_new0 (gfloat, num_power_bins);
+    cd->frame_power = g_new0 (gfloat, (gsize) num_slots * num_power_bins);
+    cd->power = cd->frame_power;
+    cd->noise = NULL;
+    if (cepstrum->noise_reduction)
+      cd->noise = gst_cepstrum_noise_new (num_power_bins,
+          gst_util_uint64_scale_ceil (NOISE_SUBWINDOW,
+              GST_AUDIO_FILTER_RATE (cepstrum),
+              (guint64) cepstrum->hop_len * GST_SECOND),
+          NOISE_NUM_SUBWINDOWS);
+    cd->sdft = NULL;
+    if (cepstrum->use_sdft)
+      cd->sdft = gst_cepstrum_sdft_new (nfft, cepstrum->win_len, bins,
+          num_bins);
+    memset (&cd->prefilter, 0, sizeof (cd->prefilter));
+    cd->prefilter.seed = 0x9e3779b9 ^ (i + 1);
+    cd->pncc = NULL;
+    cd->band_sum = NULL;
+    cd->log_bands = NULL;
+    if (pncc) {
+      cd->pncc = gst_cepstrum_pncc_new (nfilts);
+      cd->band_sum = g_new0 (gfloat, nfilts);
+      /* the onsets and modulation spectra want log energies, not the
+       * power law compressed PNCC values */
+      if (i == 0 && (cepstrum->onsets || cepstrum->modulation_frames))
+        cd->log_bands = g_new0 (gfloat, nfilts);
+    }
+    cd->mel = g_new0 (gfloat, nfilts);
+    cd->psd = NULL;
+    if (cepstrum->psd)
+      cd->psd = g_new0 (gfloat, fft_size);
+    cd->cqt = NULL;
+    if (cepstrum->num_cqt)
+      cd->cqt = g_new0 (gfloat, cepstrum->num_cqt);
+    cd->magnitude = NULL;
+    if (cepstrum->preset == GST_CEPSTRUM_PRESET_HTK && !pncc)
+      cd->magnitude = g_new0 (gfloat, num_power_bins);
+    /* Kaldi's use-energy replaces C0 with the log energy of the frame */
+    cd->frame_energy = NULL;
+    if (cepstrum->preset == GST_CEPSTRUM_PRESET_KALDI && !pncc)
+      cd->frame_energy = g_new0 (gfloat, num_slots);
+    cd->energy_sum = 0.0;
+    cd->mfcc = g_new0 (gfloat, num_coeffs);
+    cd->last_mfcc = g_new0 (gfloat, num_coeffs);
+  }
+
+  g_free (bins);
+
+  cepstrum->frame_len = cepstrum->num_channels * num_coeffs;
+  cepstrum->features = g_new0 (gfloat, cepstrum->frame_len);
+
+  cepstrum->slot_ts = g_new0 (GstClockTime, num_slots);
+  cepstrum->slot_on_hop = g_new0 (gboolean, num_slots);
+  cepstrum->intervals = g_new0 (GstCepstrumInterval, num_slots);
+  cepstrum->num_queued = 0;
+  cepstrum->num_intervals = 0;
+  if (cepstrum->num_threads > 1) {
+    GST_DEBUG_OBJECT (cepstrum, "analysing batches of %u frames on %u "
+        "threads", num_slots, cepstrum->num_threads);
+    cepstrum->jobs = g_new0 (GstCepstrumJob, cepstrum->num_threads);
+    /* the streaming thread takes a share of each batch itself */
+    cepstrum->pool = g_thread_pool_new (gst_cepstrum_analysis_func, NULL,
+        cepstrum->num_threads - 1, FALSE, NULL);
+  }
+
+  if (cepstrum->fingerprint)
+    cepstrum->fp = gst_cepstrum_fingerprint_new (fft_size);
+
+  if (cepstrum->onsets)
+    cepstrum->onset = gst_cepstrum_onset_new (nfilts, cepstrum->onset_window);
+
+  cepstrum->lsh_results = g_new0 (GstCepstrumLshResult,
+      cepstrum->lsh_num_results);
+
+  if (cepstrum->history_duration > 0) {
+    /* one frame every hop, plus the frame at each end */
+    cepstrum->history_size = 1 +
+        gst_util_uint64_scale_ceil (cepstrum->history_duration,
+        GST_AUDIO_FILTER_RATE (cepstrum),
+        (guint64) cepstrum->hop_len * GST_SECOND);
+    cepstrum->history = g_new0 (gfloat,
+        (gsize) cepstrum->history_size * cepstrum->frame_len);
+    cepstrum->history_ts = g_new0 (GstClockTime, cepstrum->history_size);
+  }
+
+  GST_DEBUG_OBJECT (cepstrum, "fft_size %d", fft_size);
+
+  if (cepstrum->scorer_info)
+    gst_cepstrum_scorer_open (cepstrum);
+
+  if (cepstrum->gmm) {
+    /* in multi-channel mode the first channel is classified */
+    cepstrum->gmm_active =
+        (gst_cepstrum_gmm_get_dim (cepstrum->gmm) == num_coeffs);
+    if (!cepstrum->gmm_active)
+      GST_WARNING_OBJECT (cepstrum, "GMM dimension %u does not match %u "
+          "coefficients, classification disabled",
+          gst_cepstrum_gmm_get_dim (cepstrum->gmm), num_coeffs);
+  }
+
+  if (cepstrum->dtw) {
+    /* in multi-channel mode the first channel is matched */
+    cepstrum->dtw_active =
+        (gst_cepstrum_dtw_get_dim (cepstrum->dtw) == num_coeffs);
+    if (!cepstrum->dtw_active)
+      GST_WARNING_OBJECT (cepstrum, "template dimension %u does not match %u "
+          "coefficients, matching disabled",
+          gst_cepstrum_dtw_get_dim (cepstrum->dtw), num_coeffs);
+  }
+
+  if (cepstrum->lsh) {
+    /* in multi-channel mode the first channel is queried */
+    cepstrum->lsh_active =
+        (gst_cepstrum_lsh_get_dim (cepstrum->lsh) == num_coeffs);
+    if (!cepstrum->lsh_active)
+      GST_WARNING_OBJECT (cepstrum, "LSH index dimension %u does not match "
+          "%u coefficients, queries disabled",
+          gst_cepstrum_lsh_get_dim (cepstrum->lsh), num_coeffs);
+  }
+}
+
+static void
+gst_cepstrum_free_channel_data (GstCepstrum * cepstrum)
+{
+  if (cepstrum->channel_data) {
+    gint i;
+    GstCepstrumChannel *cd;
+
+    GST_DEBUG_OBJECT (cepstrum, "freeing data for %d channels",
+        cepstrum->num_channels);
+
+    if (cepstrum->pool) {
+      g_thread_pool_free (cepstrum->pool, FALSE, TRUE);
+      cepstrum->pool = NULL;
+    }
+    g_free (cepstrum->jobs);
+    cepstrum->jobs = NULL;
+    g_free (cepstrum->slot_ts);
+    cepstrum->slot_ts = NULL;
+    g_free (cepstrum->slot_on_hop);
+    cepstrum->slot_on_hop = NULL;
+    g_free (cepstrum->intervals);
+    cepstrum->intervals = NULL;
+
+    for (i = 0; i < cepstrum->num_channels; i++) {
+      cd = &cepstrum->channel_data[i];
+  #ifdef HAVE_LIBFFTW
+      if (cd->fftplan) {
+        G_LOCK (fftw_planner);
+        fftw_destroy_plan(cd->fftplan);
+        G_UNLOCK (fftw_planner);
+      }
+      if (cd->fftdata)
+        fftw_free(cd->fftdata);
+      if (cd->fftin)
+        fftw_free(cd->fftin);
+  #else
+      for (guint j = 0; cd->fft_ctx && j < cepstrum->num_slots; j++)
+        gst_fft_f32_free (cd->fft_ctx[j]);
+      g_free (cd->fft_ctx);
+      g_free (cd->fftdata);
+  #endif
+      g_free (cd->input);
+      g_free (cd->input_tmp);
+      g_free (cd->mfcc);
+      g_free (cd->last_mfcc);
+      g_free (cd->mel);
+      gst_cepstrum_pncc_free (cd->pncc);
+      g_free (cd->cqt);
+      g_free (cd->psd);
+      g_free (cd->band_sum);
+      g_free (cd->log_bands);
+      g_free (cd->magnitude);
+      g_free (cd->frame_energy);
+      g_free (cd->frame_power);
+      gst_cepstrum_noise_free (cd->noise);
+      gst_cepstrum_sdft_free (cd->sdft);
+      g_free (cd->spect_magnitude);
+    }
+    free_mel_filterbank (cepstrum->filter_bank, cepstrum->num_filters);
+    g_free (cepstrum->filter_bank);
+    g_free (cepstrum->window);
+    cepstrum->window = NULL;
+    g_free (cepstrum->dct);
+    cepstrum->dct = NULL;
+    free_cqt_kernels (cepstrum);
+    g_free (cepstrum->channel_data);
+    cepstrum->channel_data = NULL;
+
+    g_free (cepstrum->features);
+    cepstrum->features = NULL;
+    gst_cepstrum_fingerprint_free (cepstrum->fp);
+    cepstrum->fp = NULL;
+    gst_cepstrum_onset_free (cepstrum->onset);
+    cepstrum->onset = NULL;
+    g_free (cepstrum->lsh_results);
+    cepstrum->lsh_results = NULL;
+    gst_cepstrum_tdoa_free (cepstrum);
+    gst_cepstrum_modulation_free (cepstrum);
+    gst_cepstrum_scorer_close (cepstrum);
+    g_free (cepstrum->history);
+    cepstrum->history = NULL;
+    g_free (cepstrum->history_ts);
+    cepstrum->history_ts = NULL;
+    cepstrum->history_size = 0;
+  }
+}
+
+static void
+gst_cepstrum_flush (GstCepstrum * cepstrum)
+{
+  guint c;
+
+  cepstrum->num_frames = 0;
+  cepstrum->num_fft = 0;
+  cepstrum->frame_index = 0;
+
+  cepstrum->accumulated_error = 0;
+  cepstrum->message_ts = GST_CLOCK_TIME_NONE;
+  cepstrum->clock_ns = GST_CLOCK_TIME_NONE;
+  cepstrum->clock_rem = 0;
+  cepstrum->have_posted = FALSE;
+  cepstrum->silence = 0;
+
+  cepstrum->scorer_pending = 0;
+  if (cepstrum->scorer_handle && cepstrum->scorer_info->reset)
+    cepstrum->scorer_info->reset (cepstrum->scorer_handle);
+
+  cepstrum->gmm_frames = 0;
+  cepstrum->gmm_class = G_MAXUINT;
+
+  if (cepstrum->dtw)
+    gst_cepstrum_dtw_reset (cepstrum->dtw);
+
+  if (cepstrum->fp)
+    gst_cepstrum_fingerprint_reset (cepstrum->fp);
+
+  if (cepstrum->onset)
+    gst_cepstrum_onset_reset (cepstrum->onset);
+
+  for (c = 0; cepstrum->channel_data && c < cepstrum->num_channels; c++) {
+    GstCepstrumChannel *cd = &cepstrum->channel_data[c];
+
+    if (cd->noise)
+      gst_cepstrum_noise_reset (cd->noise);
+    if (cd->sdft)
+      gst_cepstrum_sdft_reset (cd->sdft);
+    if (cd->pncc)
+      gst_cepstrum_pncc_reset (cd->pncc);
+    cd->prefilter.x1 = cd->prefilter.y1 = 0.0f;
+  }
+
+  /* with snip-edges, hops are aligned so the first frame ends with the
+   * first complete window */
+  cepstrum->hop_pos = 0;
+  cepstrum->warmup = 0;
+  if (cepstrum->snip_edges && cepstrum->hop_len > 0) {
+    cepstrum->hop_pos = (cepstrum->hop_len -
+        cepstrum->win_len % cepstrum->hop_len) % cepstrum->hop_len;
+    cepstrum->warmup = cepstrum->win_len;
+  }
+
+  cepstrum->history_pos = 0;
+  cepstrum->history_len = 0;
+
+  cepstrum->mod_pos = 0;
+  cepstrum->mod_count = 0;
+  cepstrum->mod_todo = 0;
+
+  cepstrum->num_queued = 0;
+  cepstrum->num_intervals = 0;
+}
+
+static void
+gst_cepstrum_reset_state (GstCepstrum * cepstrum)
+{
+  GST_DEBUG_OBJECT (cepstrum, "resetting state");
+
+  gst_cepstrum_free_channel_data (cepstrum);
+  gst_cepstrum_flush (cepstrum);
+}
+
+/* settings of the toolkits, indexed by GstCepstrumPreset - 1; frame sizes
+ * are for the sample rate listed with them */
+static const struct
+{
+  guint sample_rate;
+  guint fft_size;               /* bins, nfft / 2 + 1 */
+  guint win_size;
+  guint hop_size;
+  gboolean snip_edges;
+  GstCepstrumWindow window_type;
+  gboolean use_preemphasis;
+  gboolean remove_dc;
+  gfloat dither;
+  guint num_coeffs;
+  guint num_filters;
+  gfloat low_freq;
+  GstCepstrumMelScale mel_scale;
+  GstCepstrumMelNorm mel_norm;
+  gfloat energy_floor;
+  gfloat lifter;
+} presets[] = {
+  /* HTK: 25 ms Hamming windows every 10 ms, 26 channels, C0 to C12 with
+   * CEPLIFTER 22, log floor of 1 on 16 bit samples */
+  {16000, 257, 400, 160, TRUE, GST_CEPSTRUM_WINDOW_HAMMING, TRUE, FALSE, 0.0,
+      13, 26, 0.0, GST_CEPSTRUM_MEL_SCALE_HTK, GST_CEPSTRUM_MEL_NORM_NONE,
+      1.0, 22.0},
+  /* Kaldi: 25 ms povey windows every 10 ms with DC removal and dither, 23
+   * bins from 20 Hz, 13 cepstra liftered with 22 */
+  {16000, 257, 400, 160, TRUE, GST_CEPSTRUM_WINDOW_POVEY, TRUE, TRUE, 1.0,
+      13, 23, 20.0, GST_CEPSTRUM_MEL_SCALE_HTK, GST_CEPSTRUM_MEL_NORM_NONE,
+      FLT_EPSILON, 22.0},
+  /* librosa: 2048 point periodic Hann windows every 512 samples at
+   * 22050 Hz, 128 Slaney Mel bands in dB and 20 coefficients */
+  {22050, 1025, 2048, 512, FALSE, GST_CEPSTRUM_WINDOW_HANN, FALSE, FALSE, 0.0,
+      20, 128, 0.0, GST_CEPSTRUM_MEL_SCALE_SLANEY,
+      GST_CEPSTRUM_MEL_NORM_SLANEY, 1e-10, 0.0},
+};
+
+/* set the analysis properties of @preset, call with the lock held */
+static void
+gst_cepstrum_apply_preset (GstCepstrum * cepstrum, GstCepstrumPreset preset)
+{
+  cepstrum->preset = preset;
+  if (preset == GST_CEPSTRUM_PRESET_NONE)
+    return;
+
+  /* the toolkits compute MFCCs */
+  cepstrum->feature_type = GST_CEPSTRUM_FEATURE_TYPE_MFCC;
+  cepstrum->sample_rate = presets[preset - 1].sample_rate;
+  cepstrum->fft_size = presets[preset - 1].fft_size;
+  cepstrum->win_size = presets[preset - 1].win_size;
+  cepstrum->hop_size = presets[preset - 1].hop_size;
+  cepstrum->snip_edges = presets[preset - 1].snip_edges;
+  cepstrum->window_type = presets[preset - 1].window_type;
+  cepstrum->use_preemphasis = presets[preset - 1].use_preemphasis;
+  cepstrum->preemphasis_coeff = DEFAULT_PREEMPHASIS_COEFF;
+  cepstrum->remove_dc = presets[preset - 1].remove_dc;
+  cepstrum->dither = presets[preset - 1].dither;
+  cepstrum->num_coeffs = presets[preset - 1].num_coeffs;
+  cepstrum->mel_filters = presets[preset - 1].num_filters;
+  cepstrum->low_freq = presets[preset - 1].low_freq;
+  cepstrum->high_freq = 0.0;
+  cepstrum->mel_scale = presets[preset - 1].mel_scale;
+  cepstrum->mel_norm = presets[preset - 1].mel_norm;
+  cepstrum->energy_floor = presets[preset - 1].energy_floor;
+  cepstrum->lifter = presets[preset - 1].lifter;
+}
+
+static void
+gst_cepstrum_finalize (GObject * object)
+{
+  GstCepstrum *cepstrum = GST_CEPSTRUM (object);
+
+  gst_cepstrum_reset_state (cepstrum);
+  g_mutex_clear (&cepstrum->lock);
+  g_mutex_clear (&cepstrum->jobs_lock);
+  g_array_free (cepstrum->signal_features, TRUE);
+  g_array_free (cepstrum->signal_ts, TRUE);
+  g_cond_clear (&cepstrum->jobs_cond);
+
+  g_free (cepstrum->scorer_module);
+  g_free (cepstrum->scorer_options);
+  g_free (cepstrum->gmm_model);
+  g_free (cepstrum->template_dir);
+  g_free (cepstrum->lsh_index);
+  g_free (cepstrum->tdoa_pairs);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_cepstrum_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstCepstrum *filter = GST_CEPSTRUM (object);
+
+  switch (prop_id) {
+    case PROP_POST_MESSAGES:
+      filter->post_messages = g_value_get_boolean (value);
+      break;
+    case PROP_EMIT_SIGNALS:
+      filter->emit_signals = g_value_get_boolean (value);
+      break;
+    case PROP_CHANGE_THRESHOLD:
+      filter->change_threshold = g_value_get_float (value);
+      break;
+    case PROP_CHANGE_METRIC:
+      filter->change_metric = g_value_get_enum (value);
+      break;
+    case PROP_MAX_SILENCE:
+      filter->max_silence = g_value_get_uint64 (value);
       break;
     case PROP_INTERVAL:{
       guint64 interval = g_value_get_uint64 (value);
@@ -362,7 +2131,32 @@ gst_cepstrum_set_property (GObject * object, guint prop_id,
       g_mutex_lock (&filter->lock);
       if (filter->num_coeffs != num_coeffs) {
         filter->num_coeffs = num_coeffs;
-        filter->num_filters = 2 * num_coeffs;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_NUM_FILTERS:{
+      guint mel_filters = g_value_get_uint (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->mel_filters != mel_filters) {
+        filter->mel_filters = mel_filters;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_PRESET:
+      g_mutex_lock (&filter->lock);
+      gst_cepstrum_apply_preset (filter, g_value_get_enum (value));
+      gst_cepstrum_reset_state (filter);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_FEATURE_TYPE:{
+      GstCepstrumFeatureType feature_type = g_value_get_enum (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->feature_type != feature_type) {
+        filter->feature_type = feature_type;
         gst_cepstrum_reset_state (filter);
       }
       g_mutex_unlock (&filter->lock);
@@ -401,12 +2195,114 @@ gst_cepstrum_set_property (GObject * object, guint prop_id,
       g_mutex_unlock (&filter->lock);
       break;
     }
-    case PROP_USE_PREEMPHASIS:
-      filter->use_preemphasis = g_value_get_boolean (value);
-      break;
+    case PROP_SNIP_EDGES:{
+      gboolean snip_edges = g_value_get_boolean (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->snip_edges != snip_edges) {
+        filter->snip_edges = snip_edges;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_WINDOW_TYPE:{
+      GstCepstrumWindow window_type = g_value_get_enum (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->window_type != window_type) {
+        filter->window_type = window_type;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_DFT_MODE:{
+      GstCepstrumDftMode dft_mode = g_value_get_enum (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->dft_mode != dft_mode) {
+        filter->dft_mode = dft_mode;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_LOW_FREQ:{
+      gfloat low_freq = g_value_get_float (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->low_freq != low_freq) {
+        filter->low_freq = low_freq;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_HIGH_FREQ:{
+      gfloat high_freq = g_value_get_float (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->high_freq != high_freq) {
+        filter->high_freq = high_freq;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_MEL_SCALE:{
+      GstCepstrumMelScale mel_scale = g_value_get_enum (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->mel_scale != mel_scale) {
+        filter->mel_scale = mel_scale;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_MEL_NORM:{
+      GstCepstrumMelNorm mel_norm = g_value_get_enum (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->mel_norm != mel_norm) {
+        filter->mel_norm = mel_norm;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_ENERGY_FLOOR:
+      filter->energy_floor = g_value_get_float (value);
+      break;
+    case PROP_LIFTER:{
+      gfloat lifter = g_value_get_float (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->lifter != lifter) {
+        filter->lifter = lifter;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_USE_PREEMPHASIS:
+      filter->use_preemphasis = g_value_get_boolean (value);
+      break;
     case PROP_PREEMPHASIS_COEFF:
       filter->preemphasis_coeff = g_value_get_float (value);
       break;
+    case PROP_REMOVE_DC:
+      filter->remove_dc = g_value_get_boolean (value);
+      break;
+    case PROP_DITHER:
+      filter->dither = g_value_get_float (value);
+      break;
+    case PROP_NOISE_REDUCTION:{
+      gboolean noise_reduction = g_value_get_boolean (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->noise_reduction != noise_reduction) {
+        filter->noise_reduction = noise_reduction;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_NOISE_OVERSUBTRACTION:
+      filter->noise_oversubtraction = g_value_get_float (value);
+      break;
     case PROP_MULTI_CHANNEL:{
       gboolean multi_channel = g_value_get_boolean (value);
       g_mutex_lock (&filter->lock);
@@ -417,6 +2313,203 @@ gst_cepstrum_set_property (GObject * object, guint prop_id,
       g_mutex_unlock (&filter->lock);
       break;
     }
+    case PROP_SCORER_MODULE:
+      g_mutex_lock (&filter->lock);
+      g_free (filter->scorer_module);
+      filter->scorer_module = g_value_dup_string (value);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_SCORER_OPTIONS:
+      g_mutex_lock (&filter->lock);
+      g_free (filter->scorer_options);
+      filter->scorer_options = g_value_dup_string (value);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_SCORER_BATCH:{
+      guint scorer_batch = g_value_get_uint (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->scorer_batch != scorer_batch) {
+        filter->scorer_batch = scorer_batch;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_GMM_MODEL:
+      g_mutex_lock (&filter->lock);
+      g_free (filter->gmm_model);
+      filter->gmm_model = g_value_dup_string (value);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_GMM_SMOOTHING:
+      filter->gmm_smoothing = g_value_get_uint (value);
+      break;
+    case PROP_TEMPLATE_DIR:
+      g_mutex_lock (&filter->lock);
+      g_free (filter->template_dir);
+      filter->template_dir = g_value_dup_string (value);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_MATCH_THRESHOLD:
+      filter->match_threshold = g_value_get_float (value);
+      break;
+    case PROP_LSH_INDEX:
+      g_mutex_lock (&filter->lock);
+      g_free (filter->lsh_index);
+      filter->lsh_index = g_value_dup_string (value);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_LSH_NUM_RESULTS:{
+      guint lsh_num_results = g_value_get_uint (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->lsh_num_results != lsh_num_results) {
+        filter->lsh_num_results = lsh_num_results;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_LSH_PER_FRAME:
+      filter->lsh_per_frame = g_value_get_boolean (value);
+      break;
+    case PROP_TDOA_PAIRS:
+      g_mutex_lock (&filter->lock);
+      g_free (filter->tdoa_pairs);
+      filter->tdoa_pairs = g_value_dup_string (value);
+      gst_cepstrum_reset_state (filter);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_TDOA_MAX_DELAY:
+      filter->tdoa_max_delay = g_value_get_uint64 (value);
+      break;
+    case PROP_HISTORY_DURATION:{
+      guint64 history_duration = g_value_get_uint64 (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->history_duration != history_duration) {
+        filter->history_duration = history_duration;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_MODULATION_FRAMES:{
+      guint modulation_frames = g_value_get_uint (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->modulation_frames != modulation_frames) {
+        filter->modulation_frames = modulation_frames;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_MODULATION_HOP:
+      g_mutex_lock (&filter->lock);
+      filter->modulation_hop = g_value_get_uint (value);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_ANALYSIS_THREADS:{
+      guint analysis_threads = g_value_get_uint (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->analysis_threads != analysis_threads) {
+        filter->analysis_threads = analysis_threads;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_FFT_THREADS:{
+      guint fft_threads = g_value_get_uint (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->fft_threads != fft_threads) {
+        filter->fft_threads = fft_threads;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_ONSETS:{
+      gboolean onsets = g_value_get_boolean (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->onsets != onsets) {
+        filter->onsets = onsets;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_ONSET_THRESHOLD:
+      filter->onset_threshold = g_value_get_float (value);
+      break;
+    case PROP_ONSET_WINDOW:{
+      guint onset_window = g_value_get_uint (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->onset_window != onset_window) {
+        filter->onset_window = onset_window;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_FINGERPRINT:{
+      gboolean fingerprint = g_value_get_boolean (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->fingerprint != fingerprint) {
+        filter->fingerprint = fingerprint;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_PSD:{
+      gboolean psd = g_value_get_boolean (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->psd != psd) {
+        filter->psd = psd;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_PSD_DECIMATION:{
+      guint psd_decimation = g_value_get_uint (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->psd_decimation != psd_decimation) {
+        filter->psd_decimation = psd_decimation;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_CQT_BINS:{
+      guint cqt_bins = g_value_get_uint (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->cqt_bins != cqt_bins) {
+        filter->cqt_bins = cqt_bins;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_CQT_BINS_PER_OCTAVE:{
+      guint cqt_bins_per_octave = g_value_get_uint (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->cqt_bins_per_octave != cqt_bins_per_octave) {
+        filter->cqt_bins_per_octave = cqt_bins_per_octave;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
+    case PROP_CQT_MIN_FREQ:{
+      gfloat cqt_min_freq = g_value_get_float (value);
+      g_mutex_lock (&filter->lock);
+      if (filter->cqt_min_freq != cqt_min_freq) {
+        filter->cqt_min_freq = cqt_min_freq;
+        gst_cepstrum_reset_state (filter);
+      }
+      g_mutex_unlock (&filter->lock);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -433,23 +2526,71 @@ gst_cepstrum_get_property (GObject * object, guint prop_id,
     case PROP_POST_MESSAGES:
       g_value_set_boolean (value, filter->post_messages);
       break;
+    case PROP_EMIT_SIGNALS:
+      g_value_set_boolean (value, filter->emit_signals);
+      break;
+    case PROP_CHANGE_THRESHOLD:
+      g_value_set_float (value, filter->change_threshold);
+      break;
+    case PROP_CHANGE_METRIC:
+      g_value_set_enum (value, filter->change_metric);
+      break;
+    case PROP_MAX_SILENCE:
+      g_value_set_uint64 (value, filter->max_silence);
+      break;
     case PROP_INTERVAL:
       g_value_set_uint64 (value, filter->interval);
       break;
     case PROP_NUM_CEPSTRAL_COEFFS:
       g_value_set_uint (value, filter->num_coeffs);
       break;
+    case PROP_NUM_FILTERS:
+      g_value_set_uint (value, filter->mel_filters);
+      break;
+    case PROP_PRESET:
+      g_value_set_enum (value, filter->preset);
+      break;
+    case PROP_FEATURE_TYPE:
+      g_value_set_enum (value, filter->feature_type);
+      break;
     case PROP_SAMPLE_RATE:
-      g_value_set_int (value, filter->sample_rate);
+      g_value_set_uint (value, filter->sample_rate);
       break;
     case PROP_FFT_SIZE:
-      g_value_set_int (value, filter->fft_size);
+      g_value_set_uint (value, filter->fft_size);
       break;
     case PROP_WINDOW_SIZE:
-      g_value_set_int (value, filter->win_size);
+      g_value_set_uint (value, filter->win_size);
       break;
     case PROP_HOP_SIZE:
-      g_value_set_int (value, filter->hop_size);
+      g_value_set_uint (value, filter->hop_size);
+      break;
+    case PROP_SNIP_EDGES:
+      g_value_set_boolean (value, filter->snip_edges);
+      break;
+    case PROP_WINDOW_TYPE:
+      g_value_set_enum (value, filter->window_type);
+      break;
+    case PROP_DFT_MODE:
+      g_value_set_enum (value, filter->dft_mode);
+      break;
+    case PROP_LOW_FREQ:
+      g_value_set_float (value, filter->low_freq);
+      break;
+    case PROP_HIGH_FREQ:
+      g_value_set_float (value, filter->high_freq);
+      break;
+    case PROP_MEL_SCALE:
+      g_value_set_enum (value, filter->mel_scale);
+      break;
+    case PROP_MEL_NORM:
+      g_value_set_enum (value, filter->mel_norm);
+      break;
+    case PROP_ENERGY_FLOOR:
+      g_value_set_float (value, filter->energy_floor);
+      break;
+    case PROP_LIFTER:
+      g_value_set_float (value, filter->lifter);
       break;
     case PROP_USE_PREEMPHASIS:
       g_value_set_boolean (value, filter->use_preemphasis);
@@ -457,533 +2598,2153 @@ gst_cepstrum_get_property (GObject * object, guint prop_id,
     case PROP_PREEMPHASIS_COEFF:
       g_value_set_float (value, filter->preemphasis_coeff);
       break;
+    case PROP_REMOVE_DC:
+      g_value_set_boolean (value, filter->remove_dc);
+      break;
+    case PROP_DITHER:
+      g_value_set_float (value, filter->dither);
+      break;
+    case PROP_NOISE_REDUCTION:
+      g_value_set_boolean (value, filter->noise_reduction);
+      break;
+    case PROP_NOISE_OVERSUBTRACTION:
+      g_value_set_float (value, filter->noise_oversubtraction);
+      break;
     case PROP_MULTI_CHANNEL:
       g_value_set_boolean (value, filter->multi_channel);
       break;
+    case PROP_SCORER_MODULE:
+      g_mutex_lock (&filter->lock);
+      g_value_set_string (value, filter->scorer_module);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_SCORER_OPTIONS:
+      g_mutex_lock (&filter->lock);
+      g_value_set_string (value, filter->scorer_options);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_SCORER_BATCH:
+      g_value_set_uint (value, filter->scorer_batch);
+      break;
+    case PROP_GMM_MODEL:
+      g_mutex_lock (&filter->lock);
+      g_value_set_string (value, filter->gmm_model);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_GMM_SMOOTHING:
+      g_value_set_uint (value, filter->gmm_smoothing);
+      break;
+    case PROP_TEMPLATE_DIR:
+      g_mutex_lock (&filter->lock);
+      g_value_set_string (value, filter->template_dir);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_MATCH_THRESHOLD:
+      g_value_set_float (value, filter->match_threshold);
+      break;
+    case PROP_FINGERPRINT:
+      g_value_set_boolean (value, filter->fingerprint);
+      break;
+    case PROP_PSD:
+      g_value_set_boolean (value, filter->psd);
+      break;
+    case PROP_PSD_DECIMATION:
+      g_value_set_uint (value, filter->psd_decimation);
+      break;
+    case PROP_CQT_BINS:
+      g_value_set_uint (value, filter->cqt_bins);
+      break;
+    case PROP_CQT_BINS_PER_OCTAVE:
+      g_value_set_uint (value, filter->cqt_bins_per_octave);
+      break;
+    case PROP_CQT_MIN_FREQ:
+      g_value_set_float (value, filter->cqt_min_freq);
+      break;
+    case PROP_ONSETS:
+      g_value_set_boolean (value, filter->onsets);
+      break;
+    case PROP_ONSET_THRESHOLD:
+      g_value_set_float (value, filter->onset_threshold);
+      break;
+    case PROP_ONSET_WINDOW:
+      g_value_set_uint (value, filter->onset_window);
+      break;
+    case PROP_LSH_INDEX:
+      g_mutex_lock (&filter->lock);
+      g_value_set_string (value, filter->lsh_index);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_LSH_NUM_RESULTS:
+      g_value_set_uint (value, filter->lsh_num_results);
+      break;
+    case PROP_LSH_PER_FRAME:
+      g_value_set_boolean (value, filter->lsh_per_frame);
+      break;
+    case PROP_TDOA_PAIRS:
+      g_mutex_lock (&filter->lock);
+      g_value_set_string (value, filter->tdoa_pairs);
+      g_mutex_unlock (&filter->lock);
+      break;
+    case PROP_TDOA_MAX_DELAY:
+      g_value_set_uint64 (value, filter->tdoa_max_delay);
+      break;
+    case PROP_HISTORY_DURATION:
+      g_value_set_uint64 (value, filter->history_duration);
+      break;
+    case PROP_MODULATION_FRAMES:
+      g_value_set_uint (value, filter->modulation_frames);
+      break;
+    case PROP_MODULATION_HOP:
+      g_value_set_uint (value, filter->modulation_hop);
+      break;
+    case PROP_ANALYSIS_THREADS:
+      g_value_set_uint (value, filter->analysis_threads);
+      break;
+    case PROP_FFT_THREADS:
+      g_value_set_uint (value, filter->fft_threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
-static gboolean
-gst_cepstrum_start (GstBaseTransform * trans)
+static gboolean
+gst_cepstrum_start (GstBaseTransform * trans)
+{
+  GstCepstrum *cepstrum = GST_CEPSTRUM (trans);
+  gboolean ret;
+
+  g_mutex_lock (&cepstrum->lock);
+  gst_cepstrum_reset_state (cepstrum);
+  ret = gst_cepstrum_scorer_load (cepstrum) &&
+      gst_cepstrum_gmm_load_model (cepstrum) &&
+      gst_cepstrum_dtw_load_templates (cepstrum) &&
+      gst_cepstrum_lsh_open_index (cepstrum);
+  g_mutex_unlock (&cepstrum->lock);
+
+  return ret;
+}
+
+static gboolean
+gst_cepstrum_stop (GstBaseTransform * trans)
+{
+  GstCepstrum *cepstrum = GST_CEPSTRUM (trans);
+
+  g_mutex_lock (&cepstrum->lock);
+  gst_cepstrum_reset_state (cepstrum);
+  gst_cepstrum_scorer_unload (cepstrum);
+  gst_cepstrum_gmm_unload_model (cepstrum);
+  gst_cepstrum_dtw_unload_templates (cepstrum);
+  gst_cepstrum_lsh_close_index (cepstrum);
+  g_mutex_unlock (&cepstrum->lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_cepstrum_sink_event (GstBaseTransform * trans, GstEvent * event)
+{
+  GstCepstrum *cepstrum = GST_CEPSTRUM (trans);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
+    g_mutex_lock (&cepstrum->lock);
+    /* score the last frames even if they do not fill a batch */
+    if (cepstrum->scorer_pending > 0)
+      gst_cepstrum_scorer_run (cepstrum);
+    gst_cepstrum_dtw_drain (cepstrum);
+    g_mutex_unlock (&cepstrum->lock);
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->sink_event (trans, event);
+}
+
+/* standard normal deviate from the xorshift generator in @seed */
+static inline gfloat
+prefilter_gauss (guint32 * seed)
+{
+  gfloat u[2];
+
+  for (guint i = 0; i < 2; i++) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    u[i] = ((*seed >> 8) + 0.5f) / 16777216.0f;
+  }
+
+  return sqrtf (-2.0f * logf (u[0])) * cosf (2.0f * G_PI * u[1]);
+}
+
+/* one sample through dither, the DC blocker and the pre-emphasis filter */
+static inline gfloat
+prefilter (GstCepstrumPreFilter * filter, gfloat x)
+{
+  gfloat y;
+
+  if (filter->dither > 0.0f)
+    x += filter->dither * prefilter_gauss (&filter->seed);
+
+  y = x;
+  if (filter->dc_pole > 0.0f) {
+    y = x - filter->x1 + filter->dc_pole * filter->y1;
+    filter->x1 = x;
+  }
+  x = y - filter->emphasis * filter->y1;
+  filter->y1 = y;
+
+  return x;
+}
+
+/* mixing data readers */
+
+static void
+input_data_mixed_float (const guint8 * _in, gfloat * out, guint len,
+    guint channels, gfloat max_value, guint op, guint nfft,
+    GstCepstrumPreFilter * filter)
+{
+  guint i, j, ip = 0;
+  gfloat v;
+  gfloat *in = (gfloat *) _in;
+
+  for (j = 0; j < len; j++) {
+    v = in[ip++];
+    for (i = 1; i < channels; i++)
+      v += in[ip++];
+    out[op] = prefilter (filter, v / channels);
+    op = (op + 1) % nfft;
+  }
+}
+
+static void
+input_data_mixed_double (const guint8 * _in, gfloat * out, guint len,
+    guint channels, gfloat max_value, guint op, guint nfft,
+    GstCepstrumPreFilter * filter)
+{
+  guint i, j, ip = 0;
+  gfloat v;
+  gdouble *in = (gdouble *) _in;
+
+  for (j = 0; j < len; j++) {
+    v = in[ip++];
+    for (i = 1; i < channels; i++)
+      v += in[ip++];
+    out[op] = prefilter (filter, v / channels);
+    op = (op + 1) % nfft;
+  }
+}
+
+static void
+input_data_mixed_int32_max (const guint8 * _in, gfloat * out, guint len,
+    guint channels, gfloat max_value, guint op, guint nfft,
+    GstCepstrumPreFilter * filter)
+{
+  guint i, j, ip = 0;
+  gint32 *in = (gint32 *) _in;
+  gfloat v;
+
+  for (j = 0; j < len; j++) {
+    v = in[ip++] / max_value;
+    for (i = 1; i < channels; i++)
+      v += in[ip++] / max_value;
+    out[op] = prefilter (filter, v / channels);
+    op = (op + 1) % nfft;
+  }
+}
+
+static void
+input_data_mixed_int24_max (const guint8 * _in, gfloat * out, guint len,
+    guint channels, gfloat max_value, guint op, guint nfft,
+    GstCepstrumPreFilter * filter)
+{
+  guint i, j;
+  gfloat v = 0.0;
+
+  for (j = 0; j < len; j++) {
+    for (i = 0; i < channels; i++) {
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+      gint32 value = GST_READ_UINT24_BE (_in);
+#else
+      gint32 value = GST_READ_UINT24_LE (_in);
+#endif
+      if (value & 0x00800000)
+        value |= 0xff000000;
+      v += value / max_value;
+      _in += 3;
+    }
+    out[op] = prefilter (filter, v / channels);
+    op = (op + 1) % nfft;
+  }
+}
+
+static void
+input_data_mixed_int16_max (const guint8 * _in, gfloat * out, guint len,
+    guint channels, gfloat max_value, guint op, guint nfft,
+    GstCepstrumPreFilter * filter)
+{
+  guint i, j, ip = 0;
+  gint16 *in = (gint16 *) _in;
+  gfloat v;
+
+  for (j = 0; j < len; j++) {
+    v = in[ip++] / max_value;
+    for (i = 1; i < channels; i++)
+      v += in[ip++] / max_value;
+    out[op] = prefilter (filter, v / channels);
+    op = (op + 1) % nfft;
+  }
+}
+
+/* non mixing data readers */
+
+static void
+input_data_float (const guint8 * _in, gfloat * out, guint len, guint channels,
+    gfloat max_value, guint op, guint nfft,
+    GstCepstrumPreFilter * filter)
+{
+  guint j, ip;
+  gfloat *in = (gfloat *) _in;
+
+  for (j = 0, ip = 0; j < len; j++, ip += channels) {
+    out[op] = prefilter (filter, in[ip]);
+    op = (op + 1) % nfft;
+  }
+}
+
+static void
+input_data_double (const guint8 * _in, gfloat * out, guint len, guint channels,
+    gfloat max_value, guint op, guint nfft,
+    GstCepstrumPreFilter * filter)
+{
+  guint j, ip;
+  gdouble *in = (gdouble *) _in;
+
+  for (j = 0, ip = 0; j < len; j++, ip += channels) {
+    out[op] = prefilter (filter, in[ip]);
+    op = (op + 1) % nfft;
+  }
+}
+
+static void
+input_data_int32_max (const guint8 * _in, gfloat * out, guint len,
+    guint channels, gfloat max_value, guint op, guint nfft,
+    GstCepstrumPreFilter * filter)
+{
+  guint j, ip;
+  gint32 *in = (gint32 *) _in;
+
+  for (j = 0, ip = 0; j < len; j++, ip += channels) {
+    out[op] = prefilter (filter, in[ip] / max_value);
+    op = (op + 1) % nfft;
+  }
+}
+
+static void
+input_data_int24_max (const guint8 * _in, gfloat * out, guint len,
+    guint channels, gfloat max_value, guint op, guint nfft,
+    GstCepstrumPreFilter * filter)
+{
+  guint j;
+
+  for (j = 0; j < len; j++) {
+#if G_BYTE_ORDER == G_BIG_ENDIAN
+    gint32 v = GST_READ_UINT24_BE (_in);
+#else
+    gint32 v = GST_READ_UINT24_LE (_in);
+#endif
+    if (v & 0x00800000)
+      v |= 0xff000000;
+    _in += 3 * channels;
+    out[op] = prefilter (filter, v / max_value);
+    op = (op + 1) % nfft;
+  }
+}
+
+static void
+input_data_int16_max (const guint8 * _in, gfloat * out, guint len,
+    guint channels, gfloat max_value, guint op, guint nfft,
+    GstCepstrumPreFilter * filter)
+{
+  guint j, ip;
+  gint16 *in = (gint16 *) _in;
+
+  for (j = 0, ip = 0; j < len; j++, ip += channels) {
+    out[op] = prefilter (filter, in[ip] / max_value);
+    op = (op + 1) % nfft;
+  }
+}
+
+static gboolean
+gst_cepstrum_setup (GstAudioFilter * base, const GstAudioInfo * info)
+{
+  GstCepstrum *cepstrum = GST_CEPSTRUM (base);
+  gboolean multi_channel = cepstrum->multi_channel;
+  GstCepstrumInputData input_data = NULL;
+
+  g_mutex_lock (&cepstrum->lock);
+  /* the frame sizes of a preset are in samples at its rate */
+  if (cepstrum->preset != GST_CEPSTRUM_PRESET_NONE &&
+      GST_AUDIO_INFO_RATE (info) != cepstrum->sample_rate) {
+    g_mutex_unlock (&cepstrum->lock);
+    GST_ELEMENT_ERROR (cepstrum, CORE, NEGOTIATION,
+        ("The preset needs audio at %d Hz, not %d Hz", cepstrum->sample_rate,
+            GST_AUDIO_INFO_RATE (info)),
+        ("resample the stream, e.g. with audioresample"));
+    return FALSE;
+  }
+
+  switch (GST_AUDIO_INFO_FORMAT (info)) {
+    case GST_AUDIO_FORMAT_S16:
+      input_data =
+          multi_channel ? input_data_int16_max : input_data_mixed_int16_max;
+      cepstrum->sample_scale = 32767.0;
+      break;
+    case GST_AUDIO_FORMAT_S24:
+      input_data =
+          multi_channel ? input_data_int24_max : input_data_mixed_int24_max;
+      cepstrum->sample_scale = 8388607.0 / 256.0;
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      input_data =
+          multi_channel ? input_data_int32_max : input_data_mixed_int32_max;
+      /* the float maximum rounds to 2^31 */
+      cepstrum->sample_scale = 32768.0;
+      break;
+    case GST_AUDIO_FORMAT_F32:
+      input_data = multi_channel ? input_data_float : input_data_mixed_float;
+      cepstrum->sample_scale = 32768.0;
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      input_data = multi_channel ? input_data_double : input_data_mixed_double;
+      cepstrum->sample_scale = 32768.0;
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+  cepstrum->input_data = input_data;
+
+  gst_cepstrum_reset_state (cepstrum);
+  g_mutex_unlock (&cepstrum->lock);
+
+  return TRUE;
+}
+
+static GValue *
+gst_cepstrum_message_add_container (GstStructure * s, GType type,
+    const gchar * name)
+{
+  GValue v = { 0, };
+
+  g_value_init (&v, type);
+  /* will copy-by-value */
+  gst_structure_set_value (s, name, &v);
+  g_value_unset (&v);
+  return (GValue *) gst_structure_get_value (s, name);
+}
+
+static void
+gst_cepstrum_message_add_list (GValue * cv, gfloat * data, guint num_values)
+{
+  GValue v = { 0, };
+  guint i;
+
+  g_value_init (&v, G_TYPE_FLOAT);
+  for (i = 0; i < num_values; i++) {
+    g_value_set_float (&v, data[i]);
+    gst_value_list_append_value (cv, &v);       /* copies by value */
+  }
+  g_value_unset (&v);
+}
+
+static void
+gst_cepstrum_message_add_array (GValue * cv, gfloat * data, guint num_values)
+{
+  GValue v = { 0, };
+  GValue a = { 0, };
+  guint i;
+
+  g_value_init (&a, GST_TYPE_ARRAY);
+
+  g_value_init (&v, G_TYPE_FLOAT);
+  for (i = 0; i < num_values; i++) {
+    g_value_set_float (&v, data[i]);
+    gst_value_array_append_value (&a, &v);      /* copies by value */
+  }
+  g_value_unset (&v);
+
+  gst_value_array_append_value (cv, &a);        /* copies by value */
+  g_value_unset (&a);
+}
+
+/* decide whether the coefficients of this interval are worth a message,
+ * remembering them as the last posted ones if so */
+static gboolean
+gst_cepstrum_message_changed (GstCepstrum * cepstrum)
+{
+  guint num_coeffs = cepstrum->num_coeffs;
+  gdouble diff = 0.0, dot = 0.0, norm_a = 0.0, norm_b = 0.0, distance;
+  GstCepstrumChannel *cd;
+  guint c, i;
+
+  if (cepstrum->change_threshold <= 0.0)
+    return TRUE;
+
+  cepstrum->silence += cepstrum->interval;
+
+  if (cepstrum->have_posted && (cepstrum->max_silence == 0 ||
+          cepstrum->silence < cepstrum->max_silence)) {
+    for (c = 0; c < cepstrum->num_channels; c++) {
+      cd = &cepstrum->channel_data[c];
+      for (i = 0; i < num_coeffs; i++) {
+        gdouble a = cd->mfcc[i], b = cd->last_mfcc[i];
+
+        diff += (a - b) * (a - b);
+        dot += a * b;
+        norm_a += a * a;
+        norm_b += b * b;
+      }
+    }
+
+    if (cepstrum->change_metric == GST_CEPSTRUM_CHANGE_METRIC_COSINE)
+      distance = (norm_a > 0.0 && norm_b > 0.0) ?
+          1.0 - dot / sqrt (norm_a * norm_b) : 1.0;
+    else
+      distance = sqrt (diff);
+
+    if (distance < cepstrum->change_threshold)
+      return FALSE;
+  }
+
+  for (c = 0; c < cepstrum->num_channels; c++) {
+    cd = &cepstrum->channel_data[c];
+    memcpy (cd->last_mfcc, cd->mfcc, num_coeffs * sizeof (gfloat));
+  }
+  cepstrum->have_posted = TRUE;
+  cepstrum->silence = 0;
+
+  return TRUE;
+}
+
+/* post the element message @m, which every message of the element goes
+ * through so that the message_post probe sees all of them */
+static void
+gst_cepstrum_post_message (GstCepstrum * cepstrum, GstMessage * m)
+{
+  const GstStructure *s = gst_message_get_structure (m);
+  guint64 timestamp = GST_CLOCK_TIME_NONE;
+
+  gst_structure_get_uint64 (s, "timestamp", &timestamp);
+  GST_CEPSTRUM_PROBE3 (message_post, cepstrum, gst_structure_get_name (s),
+      timestamp);
+  gst_element_post_message (GST_ELEMENT (cepstrum), m);
+}
+
+static GstMessage *
+gst_cepstrum_message_new  (GstCepstrum * cepstrum, GstClockTime timestamp,
+    GstClockTime duration)
+{
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (cepstrum);
+  GstCepstrumChannel *cd;
+  GstStructure *s;
+  GValue *mcv = NULL;
+  GstClockTime endtime, running_time, stream_time;
+
+  GST_DEBUG_OBJECT (cepstrum,
+      "preparing message, coeffs =%d bands =%d",
+      cepstrum->num_coeffs, cepstrum->fft_size);
+
+  running_time = gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
+      timestamp);
+  stream_time = gst_segment_to_stream_time (&trans->segment, GST_FORMAT_TIME,
+      timestamp);
+  /* endtime is for backwards compatibility */
+  endtime = stream_time + duration;
+
+  s = gst_structure_new ("cepstrum",
+      "endtime", GST_TYPE_CLOCK_TIME, endtime,
+      "timestamp", G_TYPE_UINT64, timestamp,
+      "stream-time", G_TYPE_UINT64, stream_time,
+      "running-time", G_TYPE_UINT64, running_time,
+      "duration", G_TYPE_UINT64, duration, NULL);
+
+  if (!cepstrum->multi_channel) {
+    cd = &cepstrum->channel_data[0];
+
+      /* FIXME 0.11: this should be an array, not a list */
+      mcv = gst_cepstrum_message_add_container (s, GST_TYPE_LIST, "coeffs");
+      gst_cepstrum_message_add_list (mcv, cd->mfcc, cepstrum->num_coeffs);
+  } else {
+    guint c;
+    guint channels = GST_AUDIO_FILTER_CHANNELS (cepstrum);
+
+    mcv = gst_cepstrum_message_add_container (s, GST_TYPE_ARRAY, "coeffs");
+    for (c = 0; c < channels; c++) {
+      cd = &cepstrum->channel_data[c];
+      gst_cepstrum_message_add_array (mcv, cd->mfcc,
+          cepstrum->num_coeffs);
+    }
+  }
+
+  if (cepstrum->num_psd) {
+    gst_structure_set (s, "psd-bin-width", G_TYPE_FLOAT,
+        (gfloat) GST_AUDIO_FILTER_RATE (cepstrum) * cepstrum->psd_decimation /
+        (2 * cepstrum->fft_size - 2), NULL);
+    if (!cepstrum->multi_channel) {
+      mcv = gst_cepstrum_message_add_container (s, GST_TYPE_LIST, "psd");
+      gst_cepstrum_message_add_list (mcv, cepstrum->channel_data[0].psd,
+          cepstrum->num_psd);
+    } else {
+      guint c;
+
+      mcv = gst_cepstrum_message_add_container (s, GST_TYPE_ARRAY, "psd");
+      for (c = 0; c < cepstrum->num_channels; c++)
+        gst_cepstrum_message_add_array (mcv, cepstrum->channel_data[c].psd,
+            cepstrum->num_psd);
+    }
+  }
+
+  if (cepstrum->num_cqt) {
+    if (!cepstrum->multi_channel) {
+      mcv = gst_cepstrum_message_add_container (s, GST_TYPE_LIST, "cqt");
+      gst_cepstrum_message_add_list (mcv, cepstrum->channel_data[0].cqt,
+          cepstrum->num_cqt);
+    } else {
+      guint c;
+
+      mcv = gst_cepstrum_message_add_container (s, GST_TYPE_ARRAY, "cqt");
+      for (c = 0; c < cepstrum->num_channels; c++)
+        gst_cepstrum_message_add_array (mcv, cepstrum->channel_data[c].cqt,
+            cepstrum->num_cqt);
+    }
+  }
+  return gst_message_new_element (GST_OBJECT (cepstrum), s);
+}
+
+/* analysis window of @size samples */
+static void
+compute_window (gfloat *window, guint size, GstCepstrumWindow type)
+{
+  gdouble denom = size > 1 ? size - 1 : 1;
+
+  for (guint i = 0; i < size; i++) {
+    switch (type) {
+      case GST_CEPSTRUM_WINDOW_HAMMING:
+        window[i] = 0.54 - 0.46 * cos (2 * G_PI * i / denom);
+        break;
+      case GST_CEPSTRUM_WINDOW_HANN:
+        window[i] = 0.5 - 0.5 * cos (2 * G_PI * i / size);
+        break;
+      case GST_CEPSTRUM_WINDOW_POVEY:
+        window[i] = pow (0.5 - 0.5 * cos (2 * G_PI * i / denom), 0.85);
+        break;
+      default:
+        window[i] = 1.0f;
+        break;
+    }
+  }
+}
+
+/* orthonormal DCT-II matrix of @out_size rows, with the cepstral lifter
+ * folded in; HTK scales C0 like the other coefficients and puts it last,
+ * and librosa takes the Mel energies in dB */
+static void
+compute_dct_matrix (gfloat *dct, guint in_size, guint out_size,
+    gfloat lifter, GstCepstrumPreset preset)
+{
+  for (guint row = 0; row < out_size; row++, dct += in_size) {
+    guint k = preset == GST_CEPSTRUM_PRESET_HTK ?
+        (row + 1) % out_size : row;
+    gdouble scale = sqrt (2.0 / in_size);
+
+    /* orthogonalization */
+    if (k == 0 && preset != GST_CEPSTRUM_PRESET_HTK)
+      scale = sqrt (1.0 / in_size);
+    if (lifter > 0.0f)
+      scale *= 1.0 + 0.5 * lifter * sin (G_PI * k / lifter);
+    if (preset == GST_CEPSTRUM_PRESET_LIBROSA)
+      scale *= 10.0 / G_LN10;
+
+    for (guint n = 0; n < in_size; n++)
+      dct[n] = scale * cos (G_PI * k * (n + 0.5) / in_size);
+  }
+}
+
+static void
+compute_dct (gfloat *in, guint in_size, gfloat *out, guint out_size,
+    const gfloat *dct)
+{
+  for (guint k = 0; k < out_size; k++, dct += in_size) {
+      out[k] = 0.0;
+      for (guint n = 0; n < in_size; n++) {
+          out[k] += in[n] * dct[n];
+      }
+  }
+}
+
+/* Slaney's scale is linear below 1 kHz and logarithmic above */
+#define SLANEY_HZ_PER_MEL     (200.0 / 3.0)
+#define SLANEY_LOG_STEP       (log (6.4) / 27.0)
+
+static inline gdouble hz_to_mel(GstCepstrumMelScale scale, gdouble hz)
+{
+  if (scale == GST_CEPSTRUM_MEL_SCALE_SLANEY)
+    return hz < 1000.0 ? hz / SLANEY_HZ_PER_MEL :
+        15.0 + log (hz / 1000.0) / SLANEY_LOG_STEP;
+
+  return 2595.0 * log10 (1.0 + hz / 700.0);
+}
+
+static inline gdouble mel_to_hz(GstCepstrumMelScale scale, gdouble mel)
+{
+  if (scale == GST_CEPSTRUM_MEL_SCALE_SLANEY)
+    return mel < 15.0 ? mel * SLANEY_HZ_PER_MEL :
+        1000.0 * exp (SLANEY_LOG_STEP * (mel - 15.0));
+
+  return 700.0 * (pow (10.0, mel / 2595.0) - 1.0);
+}
+
+/* triangular filters spaced evenly on the Mel scale between @low_freq and
+ * @high_freq; each filter only stores the bins it covers. Without a preset
+ * the filter edges are rounded to bins. The presets evaluate the triangles
+ * at the bin frequencies instead, on the Mel scale like HTK and Kaldi or in
+ * Hz like librosa. All weights are multiplied by @gain */
+static void
+alloc_mel_filterbank (GstCepstrumMelFilter *fbank, gint nfilts,
+                gint sample_rate, gint nfft, gfloat low_freq, gfloat high_freq,
+                GstCepstrumMelScale scale, GstCepstrumMelNorm norm,
+                GstCepstrumPreset preset, gdouble gain)
+{
+  gdouble *mel = g_new (gdouble, nfilts + 2);
+  gdouble *hz = g_new (gdouble, nfilts + 2);
+  gfloat *bin = g_malloc0 ((nfilts + 2) * sizeof(gfloat));
+  guint num_bins = nfft / 2 + 1;
+  gfloat *weights = g_new (gfloat, num_bins);
+
+  gdouble lowmel = hz_to_mel (scale, low_freq);
+  gdouble highmel = hz_to_mel (scale, high_freq);
+  gdouble mel_step = (highmel - lowmel) / (nfilts + 1);
+
+  /* calculate Mel center frequencies and convert to FFT bin numbers */
+  for (guint i = 0; i <= nfilts + 1; i++) {
+    mel[i] = lowmel + i * mel_step;
+    hz[i] = mel_to_hz (scale, mel[i]);
+    bin[i] = floor ((nfft + 1) * hz[i] / sample_rate);
+  }
+
+  /* create triangular filters */
+  for (gint i = 0; i < nfilts; i++) {
+    guint first = num_bins, last = 0;
+    gdouble filter_gain = gain;
+
+    memset (weights, 0, num_bins * sizeof (gfloat));
+    if (preset == GST_CEPSTRUM_PRESET_NONE) {
+      for (guint k = bin[i]; k < bin[i+1]; k++)
+          weights[k] = (k - bin[i]) / (bin[i+1] - bin[i]);
+      for (guint k = bin[i+1]; k < bin[i+2]; k++)
+          weights[k] = (bin[i+2] - k) / (bin[i+2] - bin[i+1]);
+    } else {
+      const gdouble *p =
+          preset == GST_CEPSTRUM_PRESET_LIBROSA ? hz + i : mel + i;
+
+      for (guint k = 0; k < num_bins; k++) {
+        gdouble f = (gdouble) k * sample_rate / nfft;
+        gdouble x = preset == GST_CEPSTRUM_PRESET_LIBROSA ? f :
+            hz_to_mel (scale, f);
+
+        if (x > p[0] && x < p[2])
+          weights[k] = x <= p[1] ? (x - p[0]) / (p[1] - p[0]) :
+              (p[2] - x) / (p[2] - p[1]);
+      }
+    }
+
+    if (norm == GST_CEPSTRUM_MEL_NORM_SLANEY)
+      filter_gain *= 2.0 / (hz[i+2] - hz[i]);
+
+    for (guint k = 0; k < num_bins; k++) {
+      if (weights[k] > 0.0f) {
+        first = MIN (first, k);
+        last = k;
+      }
+    }
+    /* a filter narrower than a bin keeps one zero weight at its centre */
+    if (first > last)
+      first = last = MIN ((guint) bin[i+1], num_bins - 1);
+
+    fbank[i].start = first;
+    fbank[i].len = last - first + 1;
+    fbank[i].weights = g_new (gfloat, fbank[i].len);
+    for (guint k = 0; k < fbank[i].len; k++)
+      fbank[i].weights[k] = weights[first + k] * filter_gain;
+  }
+
+  g_free (weights);
+  g_free (bin);
+  g_free (hz);
+  g_free (mel);
+}
+
+static void
+free_mel_filterbank (GstCepstrumMelFilter *fbank, gint nfilts)
+{
+    for (guint i = 0; i < nfilts; i++) {
+        g_free (fbank[i].weights);
+    }
+}
+
+/* gammatone filters with centre frequencies spaced evenly on the ERB rate
+ * scale from @low_freq to @high_freq; the weights are the squared
+ * magnitude response of a 4th order gammatone filter at the bin
+ * frequencies, normalized to a peak of 1 and multiplied by @gain */
+static void
+alloc_gammatone_filterbank (GstCepstrumMelFilter *fbank, gint nfilts,
+                gint sample_rate, gint nfft, gfloat low_freq, gfloat high_freq,
+                gdouble gain)
+{
+  guint num_bins = nfft / 2 + 1;
+  gfloat *weights = g_new (gfloat, num_bins);
+  gdouble low_erb = 21.4 * log10 (1.0 + 0.00437 * low_freq);
+  gdouble high_erb = 21.4 * log10 (1.0 + 0.00437 * high_freq);
+  gdouble erb_step = nfilts > 1 ? (high_erb - low_erb) / (nfilts - 1) : 0.0;
+
+  for (gint i = 0; i < nfilts; i++) {
+    gdouble erb = low_erb + i * erb_step;
+    gdouble fc = (pow (10.0, erb / 21.4) - 1.0) / 0.00437;
+    gdouble bw = 1.019 * 24.7 * (0.00437 * fc + 1.0);
+    guint first = num_bins, last = 0;
+
+    for (guint k = 0; k < num_bins; k++) {
+      gdouble x = ((gdouble) k * sample_rate / nfft - fc) / bw;
+
+      weights[k] = pow (1.0 + x * x, -4.0);
+      if (weights[k] >= GAMMATONE_MIN_WEIGHT) {
+        first = MIN (first, k);
+        last = k;
+      }
+    }
+    /* a filter between two bins keeps the nearest one */
+    if (first > last)
+      first = last = MIN ((guint) floor (fc * nfft / sample_rate + 0.5),
+          num_bins - 1);
+
+    fbank[i].start = first;
+    fbank[i].len = last - first + 1;
+    fbank[i].weights = g_new (gfloat, fbank[i].len);
+    for (guint k = 0; k < fbank[i].len; k++)
+      fbank[i].weights[k] = weights[first + k] * gain;
+  }
+
+  g_free (weights);
+}
+
+static void
+compute_filterbank (const gfloat *in, gfloat *out,
+          const GstCepstrumMelFilter *fbank, guint nfilts)
 {
-  GstCepstrum *cepstrum = GST_CEPSTRUM (trans);
+    for (guint i = 0; i < nfilts; i++) {
+        const gfloat *x = in + fbank[i].start;
+        const gfloat *w = fbank[i].weights;
 
-  gst_cepstrum_reset_state (cepstrum);
+        out[i] = 0.0;
+        for (guint j = 0; j < fbank[i].len; j++) {
+            out[i] += x[j] * w[j];
+        }
+    }
+}
 
-  return TRUE;
+static void
+compute_mel_filterbank (gfloat *in, gfloat *out, GstCepstrumMelFilter *fbank,
+          guint nfilts, gfloat floor)
+{
+    compute_filterbank (in, out, fbank, nfilts);
+    for (guint i = 0; i < nfilts; i++) {
+        out[i] = log (fmaxf (out[i], floor));
+    }
 }
 
-static gboolean
-gst_cepstrum_stop (GstBaseTransform * trans)
+/* Brown and Puckette's sparse spectral kernels for the constant-Q bins below
+ * the Nyquist frequency, returns their number. Each kernel is a windowed
+ * complex exponential of Q periods centred in the analysis window and
+ * divided by it, so that applied to the spectrum of the windowed frame it
+ * gives the transform with the kernel's own window. Kernels longer than the
+ * analysis window are cut to it */
+static guint
+alloc_cqt_kernels (GstCepstrum * cepstrum, guint nfft)
 {
-  GstCepstrum *cepstrum = GST_CEPSTRUM (trans);
+  guint sample_rate = GST_AUDIO_FILTER_RATE (cepstrum);
+  guint win_len = cepstrum->win_len;
+  guint num_bins = nfft / 2 + 1;
+  guint bins_per_octave = cepstrum->cqt_bins_per_octave;
+  gdouble q = 1.0 / (pow (2.0, 1.0 / bins_per_octave) - 1.0);
+  GstCepstrumWindow type = cepstrum->window_type;
+  gfloat *kernel_window = g_new (gfloat, win_len);
+  gdouble *amp = g_new (gdouble, win_len);
+  gdouble *kre = g_new (gdouble, num_bins);
+  gdouble *kim = g_new (gdouble, num_bins);
+  guint k, num = 0, clipped = 0;
+
+  /* without an analysis window the kernels take Hamming windows */
+  if (type == GST_CEPSTRUM_WINDOW_RECTANGULAR)
+    type = GST_CEPSTRUM_WINDOW_HAMMING;
+
+  cepstrum->cqt_kernels = g_new0 (GstCepstrumCqtKernel, cepstrum->cqt_bins);
+
+  for (k = 0; k < cepstrum->cqt_bins; k++) {
+    GstCepstrumCqtKernel *kernel = &cepstrum->cqt_kernels[k];
+    gdouble freq = cepstrum->cqt_min_freq *
+        pow (2.0, (gdouble) k / bins_per_octave);
+    gdouble omega = 2.0 * G_PI * freq / sample_rate;
+    gdouble peak = 0.0;
+    guint len, offset, first, last, n;
+    gint centre, reach, lo, hi, j;
+
+    if (freq >= sample_rate / 2.0)
+      break;
 
-  gst_cepstrum_reset_state (cepstrum);
+    len = ceil (q * sample_rate / freq);
+    if (len > win_len) {
+      len = win_len;
+      clipped++;
+    }
+    offset = (win_len - len) / 2;
 
-  return TRUE;
+    compute_window (kernel_window, len, type);
+    for (n = 0; n < len; n++) {
+      gfloat w = cepstrum->window[offset + n];
+
+      amp[n] = w > 1e-6f ? kernel_window[n] / (w * len) : 0.0;
+    }
+
+    /* the kernel spectrum is concentrated around its centre frequency, so
+     * only the bins within a few times its resolution are evaluated */
+    centre = floor (freq * nfft / sample_rate + 0.5);
+    reach = ceil (CQT_KERNEL_LOBES * (gdouble) nfft / len) + 1;
+    lo = MAX (centre - reach, 0);
+    hi = MIN (centre + reach, (gint) num_bins - 1);
+
+    for (j = lo; j <= hi; j++) {
+      gdouble d = omega - 2.0 * G_PI * j / nfft;
+      gdouble cr = cos (d * offset), ci = sin (d * offset);
+      gdouble sr = cos (d), si = sin (d);
+      gdouble re = 0.0, im = 0.0;
+
+      for (n = 0; n < len; n++) {
+        gdouble t = cr * sr - ci * si;
+
+        re += amp[n] * cr;
+        im += amp[n] * ci;
+        ci = cr * si + ci * sr;
+        cr = t;
+      }
+      kre[j - lo] = re;
+      kim[j - lo] = im;
+      peak = MAX (peak, re * re + im * im);
+    }
+
+    first = hi - lo + 1;
+    last = 0;
+    for (j = 0; j <= hi - lo; j++) {
+      if (kre[j] * kre[j] + kim[j] * kim[j] >=
+          CQT_KERNEL_THRESHOLD * CQT_KERNEL_THRESHOLD * peak) {
+        first = MIN (first, (guint) j);
+        last = j;
+      }
+    }
+    if (first > last)
+      first = last = centre - lo;
+
+    kernel->start = lo + first;
+    kernel->len = last - first + 1;
+    kernel->re = g_new (gfloat, kernel->len);
+    kernel->im = g_new (gfloat, kernel->len);
+    for (n = 0; n < kernel->len; n++) {
+      kernel->re[n] = kre[first + n] / nfft;
+      kernel->im[n] = -kim[first + n] / nfft;
+    }
+    num++;
+  }
+
+  if (clipped)
+    GST_WARNING_OBJECT (cepstrum, "%u constant-Q bins need more than the %u "
+        "samples of the window and lose resolution", clipped, win_len);
+  if (num < cepstrum->cqt_bins)
+    GST_WARNING_OBJECT (cepstrum, "only %u of %u constant-Q bins are below "
+        "the Nyquist frequency", num, cepstrum->cqt_bins);
+
+  g_free (kim);
+  g_free (kre);
+  g_free (amp);
+  g_free (kernel_window);
+
+  return num;
 }
 
-/* mixing data readers */
+static void
+free_cqt_kernels (GstCepstrum * cepstrum)
+{
+  for (guint k = 0; cepstrum->cqt_kernels && k < cepstrum->num_cqt; k++) {
+    g_free (cepstrum->cqt_kernels[k].re);
+    g_free (cepstrum->cqt_kernels[k].im);
+  }
+  g_free (cepstrum->cqt_kernels);
+  cepstrum->cqt_kernels = NULL;
+  cepstrum->num_cqt = 0;
+}
 
+/* add the constant-Q power of the current frame spectrum to cd->cqt, scaled
+ * like the power spectrum */
 static void
-input_data_mixed_float (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
+compute_cqt (GstCepstrum * cepstrum, GstCepstrumChannel * cd)
 {
-  guint i, j, ip = 0;
-  gfloat v;
-  gfloat *in = (gfloat *) _in;
+  guint nfft = 2 * cepstrum->fft_size - 2;
+  gfloat scale = nfft / gst_cepstrum_power_scale (nfft);
+
+  for (guint k = 0; k < cepstrum->num_cqt; k++) {
+    const GstCepstrumCqtKernel *kernel = &cepstrum->cqt_kernels[k];
+    const gfloat *kre = kernel->re;
+    const gfloat *kim = kernel->im;
+    gfloat re = 0.0f, im = 0.0f;
+#ifdef HAVE_LIBFFTW
+    const fftw_complex *x = cd->spectrum + kernel->start;
 
-  for (j = 0; j < len; j++) {
-    v = in[ip++];
-    for (i = 1; i < channels; i++)
-      v += in[ip++];
-    out[op] = v / channels;
-    op = (op + 1) % nfft;
+    for (guint j = 0; j < kernel->len; j++) {
+      re += x[j][0] * kre[j] - x[j][1] * kim[j];
+      im += x[j][0] * kim[j] + x[j][1] * kre[j];
+    }
+#else
+    const GstFFTF32Complex *x = cd->spectrum + kernel->start;
+
+    for (guint j = 0; j < kernel->len; j++) {
+      re += x[j].r * kre[j] - x[j].i * kim[j];
+      im += x[j].r * kim[j] + x[j].i * kre[j];
+    }
+#endif
+    cd->cqt[k] += (re * re + im * im) * scale;
   }
 }
 
+/* power spectrum of the frame in @slot */
 static void
-input_data_mixed_double (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
+gst_cepstrum_fft (GstCepstrum * cepstrum, GstCepstrumChannel * cd, guint slot)
 {
-  guint i, j, ip = 0;
-  gfloat v;
-  gdouble *in = (gdouble *) _in;
+  guint fft_size = cepstrum->fft_size;
+  guint nfft = 2 * fft_size - 2;
+  guint bin_lo = cepstrum->bin_lo;
+  guint num_bins = cepstrum->bin_hi - bin_lo;
+  gfloat *input_tmp = cd->input_tmp + (gsize) slot * cepstrum->slot_stride;
+  gfloat *frame_power = cd->frame_power + (gsize) slot * num_bins;
+  gdouble val;
+#ifdef HAVE_LIBFFTW
+  gdouble *fftin = cd->fftin + (gsize) slot * cepstrum->fftin_stride;
+  fftw_complex *fftdata =
+      cd->fftdata + (gsize) slot * cepstrum->spectrum_stride;
 
-  for (j = 0; j < len; j++) {
-    v = in[ip++];
-    for (i = 1; i < channels; i++)
-      v += in[ip++];
-    out[op] = v / channels;
-    op = (op + 1) % nfft;
+  for (guint i = 0; i < cepstrum->win_len; i++)
+    fftin[i] = input_tmp[i];
+  fftw_execute_dft_r2c (cd->fftplan, fftin, fftdata);
+
+  /* compute power spectrum */
+  for (guint i = bin_lo; i < cepstrum->bin_hi; i++) {
+    val = fftdata[i][0] * fftdata[i][0];
+    val += fftdata[i][1] * fftdata[i][1];
+    val /= gst_cepstrum_power_scale (nfft);
+    frame_power[i - bin_lo] = val;
+  }
+#else
+  GstFFTF32Complex *fftdata =
+      cd->fftdata + (gsize) slot * cepstrum->spectrum_stride;
+
+  gst_fft_f32_fft (cd->fft_ctx[slot], input_tmp, fftdata);
+
+  /* compute power spectrum */
+  for (guint i = bin_lo; i < cepstrum->bin_hi; i++) {
+    val = fftdata[i].r * fftdata[i].r;
+    val += fftdata[i].i * fftdata[i].i;
+    val /= gst_cepstrum_power_scale (nfft);
+    frame_power[i - bin_lo] = val;
   }
+#endif
 }
 
+/* copy the frame ending at @input_pos out of the input ring into @slot */
+/* the toolkits pre-process every frame on its own, in Kaldi's order:
+ * dither, removal of the frame mean, the raw log energy, pre-emphasis of
+ * the frame with x[0] -= a * x[0], and then the window. This runs in stream
+ * order, which keeps the dither reproducible */
 static void
-input_data_mixed_int32_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
+gst_cepstrum_frame_prefilter (GstCepstrum * cepstrum, GstCepstrumChannel * cd,
+    gfloat * frame, guint slot)
 {
-  guint i, j, ip = 0;
-  gint32 *in = (gint32 *) _in;
-  gfloat v;
+  guint frame_size = cepstrum->win_len;
+  gfloat dither = cepstrum->dither / cepstrum->sample_scale;
+  gfloat a = cepstrum->use_preemphasis ? cepstrum->preemphasis_coeff : 0.0f;
+  guint i;
 
-  for (j = 0; j < len; j++) {
-    v = in[ip++] / max_value;
-    for (i = 1; i < channels; i++)
-      v += in[ip++] / max_value;
-    out[op] = v / channels;
-    op = (op + 1) % nfft;
+  if (dither > 0.0f)
+    for (i = 0; i < frame_size; i++)
+      frame[i] += dither * prefilter_gauss (&cd->prefilter.seed);
+
+  if (cepstrum->remove_dc) {
+    gdouble mean = 0.0;
+
+    for (i = 0; i < frame_size; i++)
+      mean += frame[i];
+    mean /= frame_size;
+    for (i = 0; i < frame_size; i++)
+      frame[i] -= mean;
+  }
+
+  /* Kaldi's default raw-energy, before pre-emphasis and the window */
+  if (cd->frame_energy) {
+    gdouble energy = 0.0;
+
+    for (i = 0; i < frame_size; i++)
+      energy += frame[i] * frame[i];
+    cd->frame_energy[slot] = energy;
+  }
+
+  if (a > 0.0f) {
+    for (i = frame_size - 1; i > 0; i--)
+      frame[i] -= a * frame[i - 1];
+    frame[0] -= a * frame[0];
   }
 }
 
 static void
-input_data_mixed_int24_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
+gst_cepstrum_frame_copy (GstCepstrum * cepstrum, GstCepstrumChannel * cd,
+    guint input_pos, guint slot)
 {
-  guint i, j;
-  gfloat v = 0.0;
+  guint frame_size = cepstrum->win_len;
+  guint head = frame_size - input_pos;
+  gfloat *input = cd->input;
+  gfloat *input_tmp = cd->input_tmp + (gsize) slot * cepstrum->slot_stride;
 
-  for (j = 0; j < len; j++) {
-    for (i = 0; i < channels; i++) {
-#if G_BYTE_ORDER == G_BIG_ENDIAN
-      gint32 value = GST_READ_UINT24_BE (_in);
-#else
-      gint32 value = GST_READ_UINT24_LE (_in);
-#endif
-      if (value & 0x00800000)
-        value |= 0xff000000;
-      v += value / max_value;
-      _in += 3;
-    }
-    out[op] = v / channels;
-    op = (op + 1) % nfft;
-  }
+  /* input_pos is the oldest sample of the ring */
+  memcpy (input_tmp, input + input_pos, head * sizeof (gfloat));
+  memcpy (input_tmp + head, input, input_pos * sizeof (gfloat));
+
+  if (cepstrum->preset != GST_CEPSTRUM_PRESET_NONE)
+    gst_cepstrum_frame_prefilter (cepstrum, cd, input_tmp, slot);
 }
 
+/* window and transform the frame in @slot; frames are independent here, so
+ * this runs on the analysis threads */
 static void
-input_data_mixed_int16_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
+gst_cepstrum_frame_spectrum (GstCepstrum * cepstrum, GstCepstrumChannel * cd,
+    guint slot)
 {
-  guint i, j, ip = 0;
-  gint16 *in = (gint16 *) _in;
-  gfloat v;
+  guint frame_size = cepstrum->win_len;
+  gfloat *input_tmp = cd->input_tmp + (gsize) slot * cepstrum->slot_stride;
 
-  for (j = 0; j < len; j++) {
-    v = in[ip++] / max_value;
-    for (i = 1; i < channels; i++)
-      v += in[ip++] / max_value;
-    out[op] = v / channels;
-    op = (op + 1) % nfft;
-  }
+  /* the frame is pre-filtered already, in the ring or on its own for the
+   * presets, apply the window */
+  for (guint i = 0; i < frame_size; i++)
+    input_tmp[i] *= cepstrum->window[i];
+
+  /* run FFT */
+  gst_cepstrum_fft (cepstrum, cd, slot);
 }
 
-/* non mixing data readers */
+/* the spectrum the Mel filterbank takes: @power, or its square root for
+ * the HTK preset */
+static inline gfloat *
+gst_cepstrum_filterbank_input (GstCepstrumChannel * cd, gfloat * power,
+    guint num_bins)
+{
+  if (cd->magnitude == NULL)
+    return power;
+
+  for (guint i = 0; i < num_bins; i++)
+    cd->magnitude[i] = sqrtf (power[i]);
+  return cd->magnitude;
+}
 
+/* coefficients of the frame in @slot; runs in stream order */
 static void
-input_data_float (const guint8 * _in, gfloat * out, guint len, guint channels,
-    gfloat max_value, guint op, guint nfft)
+gst_cepstrum_frame_features (GstCepstrum * cepstrum, GstCepstrumChannel * cd,
+    guint slot)
 {
-  guint j, ip;
-  gfloat *in = (gfloat *) _in;
+  guint i;
+  guint num_bins = cepstrum->bin_hi - cepstrum->bin_lo;
+  gfloat *spect_magnitude = cd->spect_magnitude;
 
-  for (j = 0, ip = 0; j < len; j++, ip += channels) {
-    out[op] = in[ip];
-    op = (op + 1) % nfft;
+  cd->power = cd->frame_power + (gsize) slot * num_bins;
+  cd->spectrum = cd->fftdata + (gsize) slot * cepstrum->spectrum_stride;
+
+  /* the PSD takes the power before noise subtraction; its bins start at 0 */
+  if (cd->psd)
+    for (i = 0; i < num_bins; i++)
+      cd->psd[i] += cd->power[i];
+
+  /* the noise tracker needs the frames in order, so it runs here and not
+   * with the parallel spectrum */
+  if (cd->noise)
+    gst_cepstrum_noise_process (cd->noise, cd->power,
+        cepstrum->noise_oversubtraction);
+
+  for (i = 0; i < num_bins; i++)
+    spect_magnitude[i] += cd->power[i];
+
+  if (cd->cqt)
+    compute_cqt (cepstrum, cd);
+
+  if (cd->pncc) {
+    /* gammatone band powers, with the smoothing state of this channel */
+    compute_filterbank (cd->power, cd->mel, cepstrum->filter_bank,
+        cepstrum->num_filters);
+    if (cd->log_bands)
+      for (i = 0; i < cepstrum->num_filters; i++)
+        cd->log_bands[i] = log (fmaxf (cd->mel[i], cepstrum->energy_floor));
+    gst_cepstrum_pncc_process (cd->pncc, cd->mel);
+    for (i = 0; i < cepstrum->num_filters; i++)
+      cd->band_sum[i] += cd->mel[i];
+  } else {
+    /* apply Mel filterbank to the power spectrum of this frame */
+    compute_mel_filterbank (gst_cepstrum_filterbank_input (cd, cd->power,
+            num_bins), cd->mel, cepstrum->filter_bank,
+        cepstrum->num_filters, cepstrum->energy_floor);
+  }
+
+  /* apply DCT to Mel coefficients to get MFCCs */
+  compute_dct (cd->mel, cepstrum->num_filters, cd->mfcc,
+      cepstrum->num_coeffs, cepstrum->dct);
+
+  if (cd->frame_energy) {
+    /* on the scale of 16 bit samples, like the filterbank */
+    gdouble energy = cd->frame_energy[slot] * cepstrum->sample_scale *
+        cepstrum->sample_scale;
+
+    cd->energy_sum += energy;
+    cd->mfcc[0] = log (MAX (energy, cepstrum->energy_floor));
   }
 }
 
+/* turn the power summed over @num_fft frames into the one-sided Welch PSD
+ * of the input, in full scale squared per Hz, and average groups of
+ * psd_decimation bins in place. The window energy is normalized out, and so
+ * is the pre-emphasis of the input ring; the DC blocker is not. */
 static void
-input_data_double (const guint8 * _in, gfloat * out, guint len, guint channels,
-    gfloat max_value, guint op, guint nfft)
+gst_cepstrum_welch_psd (GstCepstrum * cepstrum, GstCepstrumChannel * cd,
+    guint num_fft)
 {
-  guint j, ip;
-  gdouble *in = (gdouble *) _in;
+  guint fft_size = cepstrum->fft_size;
+  guint nfft = 2 * fft_size - 2;
+  guint decimation = cepstrum->psd_decimation;
+  gdouble scale = gst_cepstrum_power_scale (nfft) /
+      ((gdouble) num_fft * GST_AUDIO_FILTER_RATE (cepstrum) *
+      cepstrum->psd_norm);
+  gdouble a = cepstrum->use_preemphasis ? cepstrum->preemphasis_coeff : 0.0;
+  guint b, k;
+
+  for (b = 0; b < cepstrum->num_psd; b++) {
+    guint first = b * decimation;
+    guint last = MIN (first + decimation, fft_size);
+    gdouble sum = 0.0;
+
+    for (k = first; k < last; k++) {
+      gdouble p = cd->psd[k] * scale;
+      gdouble emphasis = 1.0 - 2.0 * a * cos (G_PI * k / (fft_size - 1)) +
+          a * a;
+
+      /* the negative frequencies fold onto all bins but DC and Nyquist */
+      if (k > 0 && k < fft_size - 1)
+        p *= 2.0;
+      sum += emphasis > 1e-6 ? p / emphasis : p;
+    }
+    cd->psd[b] = sum / (last - first);
+  }
+}
 
-  for (j = 0, ip = 0; j < len; j++, ip += channels) {
-    out[op] = in[ip];
-    op = (op + 1) % nfft;
+static void
+gst_cepstrum_prepare_message_data (GstCepstrum * cepstrum,
+    GstCepstrumChannel * cd, guint num_fft)
+{
+  guint i;
+  guint nfilts = cepstrum->num_filters;
+  gfloat *spect_magnitude = cd->spect_magnitude;
+
+  /* Calculate average */
+  for (i = 0; i < cepstrum->bin_hi - cepstrum->bin_lo; i++) {
+    spect_magnitude[i] /= num_fft;
   }
+  for (i = 0; i < cepstrum->num_cqt; i++)
+    cd->cqt[i] /= num_fft;
+
+  if (cd->psd)
+    gst_cepstrum_welch_psd (cepstrum, cd, num_fft);
+
+  if (cd->pncc) {
+    /* the PNCC state only advances with frames, so the interval takes the
+     * average of their band values instead */
+    for (i = 0; i < nfilts; i++)
+      cd->mel[i] = cd->band_sum[i] / num_fft;
+  } else {
+    /* coefficients of the interval are those of the averaged spectrum */
+    compute_mel_filterbank (gst_cepstrum_filterbank_input (cd,
+            spect_magnitude, cepstrum->bin_hi - cepstrum->bin_lo), cd->mel,
+        cepstrum->filter_bank, nfilts, cepstrum->energy_floor);
+  }
+  compute_dct (cd->mel, nfilts, cd->mfcc, cepstrum->num_coeffs,
+      cepstrum->dct);
+  if (cd->frame_energy)
+    cd->mfcc[0] = log (MAX (cd->energy_sum / num_fft,
+            cepstrum->energy_floor));
 }
 
 static void
-input_data_int32_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
+gst_cepstrum_reset_message_data (GstCepstrum * cepstrum,
+    GstCepstrumChannel * cd)
 {
-  guint j, ip;
-  gint32 *in = (gint32 *) _in;
+  guint num_bins = cepstrum->bin_hi - cepstrum->bin_lo;
+  guint mfcc_size = cepstrum->num_coeffs;
+  gfloat *spect_magnitude = cd->spect_magnitude;
+  gfloat *mfcc = cd->mfcc;
 
-  for (j = 0, ip = 0; j < len; j++, ip += channels) {
-    out[op] = in[ip] / max_value;
-    op = (op + 1) % nfft;
+  /* reset accumulators */
+  memset (spect_magnitude, 0, num_bins * sizeof (gfloat));
+  memset (mfcc, 0, mfcc_size * sizeof (gfloat));
+  if (cd->band_sum)
+    memset (cd->band_sum, 0, cepstrum->num_filters * sizeof (gfloat));
+  if (cd->cqt)
+    memset (cd->cqt, 0, cepstrum->num_cqt * sizeof (gfloat));
+  if (cd->psd)
+    memset (cd->psd, 0, cepstrum->fft_size * sizeof (gfloat));
+  cd->energy_sum = 0.0;
+}
+
+/* move the sample clock past @samples input samples, exactly and without
+ * 64 bit scaling: whole nanoseconds and the remainder in 1/rate ns are kept
+ * apart, so the rounding never accumulates */
+static inline void
+gst_cepstrum_clock_advance (GstCepstrum * cepstrum, guint samples, guint rate)
+{
+  if (!GST_CLOCK_TIME_IS_VALID (cepstrum->clock_ns))
+    return;
+
+  cepstrum->clock_ns += samples * cepstrum->sample_ns;
+  cepstrum->clock_rem += samples * cepstrum->sample_rem;
+  if (cepstrum->clock_rem >= rate) {
+    cepstrum->clock_ns += cepstrum->clock_rem / rate;
+    cepstrum->clock_rem %= rate;
   }
 }
 
+/* time of the first sample of the window ending at the clock, frames that
+ * reach back before the first sample are stamped with that sample */
+static GstClockTime
+gst_cepstrum_frame_timestamp (GstCepstrum * cepstrum)
+{
+  guint64 window;
+
+  if (!GST_CLOCK_TIME_IS_VALID (cepstrum->clock_ns))
+    return GST_CLOCK_TIME_NONE;
+
+  window = cepstrum->window_ns +
+      (cepstrum->clock_rem < cepstrum->window_rem ? 1 : 0);
+  if (cepstrum->clock_ns < cepstrum->clock_start + window)
+    return cepstrum->clock_start;
+
+  return cepstrum->clock_ns - window;
+}
+
 static void
-input_data_int24_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
+gst_cepstrum_scorer_run (GstCepstrum * cepstrum)
 {
-  guint j;
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (cepstrum);
+  const GstCepstrumScorerInfo *info = cepstrum->scorer_info;
+  guint num_frames = cepstrum->scorer_pending;
+  guint num_outputs = cepstrum->scorer_num_outputs;
+  GstClockTime running_time;
+  GstStructure *s;
+  GstBuffer *scores;
 
-  for (j = 0; j < len; j++) {
-#if G_BYTE_ORDER == G_BIG_ENDIAN
-    gint32 v = GST_READ_UINT24_BE (_in);
-#else
-    gint32 v = GST_READ_UINT24_LE (_in);
-#endif
-    if (v & 0x00800000)
-      v |= 0xff000000;
-    _in += 3 * channels;
-    out[op] = v / max_value;
-    op = (op + 1) % nfft;
+  cepstrum->scorer_pending = 0;
+
+  if (!info->score (cepstrum->scorer_handle, cepstrum->scorer_frames,
+          num_frames, cepstrum->frame_len, cepstrum->scorer_scores)) {
+    GST_WARNING_OBJECT (cepstrum, "scorer failed on %u frames", num_frames);
+    return;
   }
+
+  running_time = gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
+      cepstrum->scorer_ts);
+  scores = gst_buffer_new_memdup (cepstrum->scorer_scores,
+      num_frames * num_outputs * sizeof (gfloat));
+
+  s = gst_structure_new ("cepstrum-score",
+      "timestamp", G_TYPE_UINT64, cepstrum->scorer_ts,
+      "running-time", G_TYPE_UINT64, running_time,
+      "num-frames", G_TYPE_UINT, num_frames,
+      "num-outputs", G_TYPE_UINT, num_outputs,
+      "scores", GST_TYPE_BUFFER, scores, NULL);
+  gst_buffer_unref (scores);
+
+  gst_cepstrum_post_message (cepstrum,
+      gst_message_new_element (GST_OBJECT (cepstrum), s));
 }
 
 static void
-input_data_int16_max (const guint8 * _in, gfloat * out, guint len,
-    guint channels, gfloat max_value, guint op, guint nfft)
+gst_cepstrum_gmm_classify (GstCepstrum * cepstrum, const gfloat * features,
+    GstClockTime timestamp)
 {
-  guint j, ip;
-  gint16 *in = (gint16 *) _in;
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (cepstrum);
+  guint num_classes = gst_cepstrum_gmm_get_num_classes (cepstrum->gmm);
+  gfloat *loglik = cepstrum->gmm_loglik;
+  gfloat *smoothed = cepstrum->gmm_smoothed;
+  gfloat alpha = 1.0f / cepstrum->gmm_smoothing;
+  gdouble norm = 0.0;
+  guint c, best = 0;
+  GstStructure *s;
 
-  for (j = 0, ip = 0; j < len; j++, ip += channels) {
-    out[op] = in[ip] / max_value;
-    op = (op + 1) % nfft;
+  gst_cepstrum_gmm_score (cepstrum->gmm, features, loglik);
+
+  for (c = 0; c < num_classes; c++) {
+    if (cepstrum->gmm_frames == 0)
+      smoothed[c] = loglik[c];
+    else
+      smoothed[c] += alpha * (loglik[c] - smoothed[c]);
+    if (smoothed[c] > smoothed[best])
+      best = c;
   }
+  cepstrum->gmm_frames++;
+
+  if (best == cepstrum->gmm_class)
+    return;
+  cepstrum->gmm_class = best;
+
+  for (c = 0; c < num_classes; c++)
+    norm += exp (smoothed[c] - smoothed[best]);
+
+  s = gst_structure_new ("cepstrum-gmm",
+      "timestamp", G_TYPE_UINT64, timestamp,
+      "running-time", G_TYPE_UINT64,
+      gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
+          timestamp),
+      "class", G_TYPE_UINT, best,
+      "confidence", G_TYPE_FLOAT, (gfloat) (1.0 / norm), NULL);
+
+  gst_cepstrum_post_message (cepstrum,
+      gst_message_new_element (GST_OBJECT (cepstrum), s));
 }
 
-static gboolean
-gst_cepstrum_setup (GstAudioFilter * base, const GstAudioInfo * info)
+static void
+gst_cepstrum_dtw_post (GstCepstrum * cepstrum,
+    const GstCepstrumDtwMatch * matches, guint num_matches)
 {
-  GstCepstrum *cepstrum = GST_CEPSTRUM (base);
-  gboolean multi_channel = cepstrum->multi_channel;
-  GstCepstrumInputData input_data = NULL;
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (cepstrum);
+  guint i;
 
-  g_mutex_lock (&cepstrum->lock);
-  switch (GST_AUDIO_INFO_FORMAT (info)) {
-    case GST_AUDIO_FORMAT_S16:
-      input_data =
-          multi_channel ? input_data_int16_max : input_data_mixed_int16_max;
-      break;
-    case GST_AUDIO_FORMAT_S24:
-      input_data =
-          multi_channel ? input_data_int24_max : input_data_mixed_int24_max;
-      break;
-    case GST_AUDIO_FORMAT_S32:
-      input_data =
-          multi_channel ? input_data_int32_max : input_data_mixed_int32_max;
-      break;
-    case GST_AUDIO_FORMAT_F32:
-      input_data = multi_channel ? input_data_float : input_data_mixed_float;
-      break;
-    case GST_AUDIO_FORMAT_F64:
-      input_data = multi_channel ? input_data_double : input_data_mixed_double;
-      break;
-    default:
-      g_assert_not_reached ();
-      break;
+  for (i = 0; i < num_matches; i++) {
+    const GstCepstrumDtwMatch *m = &matches[i];
+    GstStructure *s;
+
+    GST_DEBUG_OBJECT (cepstrum, "template %s matched at %" GST_TIME_FORMAT
+        ", distance %f", m->name, GST_TIME_ARGS (m->start_ts), m->distance);
+
+    s = gst_structure_new ("cepstrum-match",
+        "template", G_TYPE_STRING, m->name,
+        "timestamp", G_TYPE_UINT64, m->start_ts,
+        "running-time", G_TYPE_UINT64,
+        gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
+            m->start_ts),
+        "duration", G_TYPE_UINT64, GST_CLOCK_TIME_IS_VALID (m->start_ts) ?
+        m->end_ts - m->start_ts : GST_CLOCK_TIME_NONE,
+        "distance", G_TYPE_FLOAT, m->distance, NULL);
+
+    gst_cepstrum_post_message (cepstrum,
+        gst_message_new_element (GST_OBJECT (cepstrum), s));
   }
-  cepstrum->input_data = input_data;
+}
 
-  gst_cepstrum_reset_state (cepstrum);
-  g_mutex_unlock (&cepstrum->lock);
+static void
+gst_cepstrum_dtw_match (GstCepstrum * cepstrum, const gfloat * features,
+    GstClockTime timestamp)
+{
+  const GstCepstrumDtwMatch *matches;
+  guint num_matches;
 
-  return TRUE;
+  num_matches = gst_cepstrum_dtw_push (cepstrum->dtw, features, timestamp,
+      cepstrum->match_threshold, &matches);
+  gst_cepstrum_dtw_post (cepstrum, matches, num_matches);
 }
 
-static GValue *
-gst_cepstrum_message_add_container (GstStructure * s, GType type,
-    const gchar * name)
+/* report matches that ended on the last frame before a discontinuity or
+ * the end of the stream */
+static void
+gst_cepstrum_dtw_drain (GstCepstrum * cepstrum)
 {
-  GValue v = { 0, };
+  const GstCepstrumDtwMatch *matches;
+  guint num_matches;
 
-  g_value_init (&v, type);
-  /* will copy-by-value */
-  gst_structure_set_value (s, name, &v);
-  g_value_unset (&v);
-  return (GValue *) gst_structure_get_value (s, name);
+  if (!cepstrum->dtw_active)
+    return;
+
+  num_matches = gst_cepstrum_dtw_finish (cepstrum->dtw, &matches);
+  gst_cepstrum_dtw_post (cepstrum, matches, num_matches);
 }
 
 static void
-gst_cepstrum_message_add_list (GValue * cv, gfloat * data, guint num_values)
+gst_cepstrum_lsh_lookup (GstCepstrum * cepstrum, const gfloat * features,
+    GstClockTime timestamp)
 {
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (cepstrum);
+  GstCepstrumLshResult *results = cepstrum->lsh_results;
+  GValue ids = { 0, };
+  GValue distances = { 0, };
   GValue v = { 0, };
-  guint i;
-
-  g_value_init (&v, G_TYPE_FLOAT);
-  for (i = 0; i < num_values; i++) {
-    g_value_set_float (&v, data[i]);
-    gst_value_list_append_value (cv, &v);       /* copies by value */
+  GstStructure *s;
+  guint i, num_results;
+
+  num_results = gst_cepstrum_lsh_query (cepstrum->lsh, features, results,
+      cepstrum->lsh_num_results);
+
+  g_value_init (&ids, GST_TYPE_ARRAY);
+  g_value_init (&distances, GST_TYPE_ARRAY);
+  g_value_init (&v, G_TYPE_UINT);
+  for (i = 0; i < num_results; i++) {
+    g_value_set_uint (&v, results[i].id);
+    gst_value_array_append_value (&ids, &v);
+    g_value_set_uint (&v, results[i].distance);
+    gst_value_array_append_value (&distances, &v);
   }
   g_value_unset (&v);
+
+  s = gst_structure_new ("cepstrum-lsh",
+      "timestamp", G_TYPE_UINT64, timestamp,
+      "running-time", G_TYPE_UINT64,
+      gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
+          timestamp), NULL);
+  gst_structure_take_value (s, "ids", &ids);
+  gst_structure_take_value (s, "distances", &distances);
+
+  gst_cepstrum_post_message (cepstrum,
+      gst_message_new_element (GST_OBJECT (cepstrum), s));
+}
+
+/* GCC-PHAT delay between channels @a and @b of the last frame, in samples */
+static gfloat
+gst_cepstrum_tdoa_estimate (GstCepstrum * cepstrum, guint a, guint b,
+    guint max_lag)
+{
+  guint fft_size = cepstrum->fft_size;
+  guint nfft = 2 * fft_size - 2;
+  gdouble y0, y1, y2, denom, best = -G_MAXDOUBLE;
+  gint lag, peak = 0;
+  guint k;
+#ifdef HAVE_LIBFFTW
+  fftw_complex *xa = cepstrum->channel_data[a].spectrum;
+  fftw_complex *xb = cepstrum->channel_data[b].spectrum;
+  fftw_complex *cross = cepstrum->tdoa_cross;
+  gdouble *corr = cepstrum->tdoa_corr;
+
+  /* cross power spectrum with phase transform weighting */
+  for (k = 0; k < fft_size; k++) {
+    gdouble re = xa[k][0] * xb[k][0] + xa[k][1] * xb[k][1];
+    gdouble im = xa[k][1] * xb[k][0] - xa[k][0] * xb[k][1];
+    gdouble mag = sqrt (re * re + im * im);
+
+    if (mag > 1e-20) {
+      cross[k][0] = re / mag;
+      cross[k][1] = im / mag;
+    } else {
+      cross[k][0] = cross[k][1] = 0.0;
+    }
+  }
+  fftw_execute (cepstrum->tdoa_plan);
+#else
+  GstFFTF32Complex *xa = cepstrum->channel_data[a].spectrum;
+  GstFFTF32Complex *xb = cepstrum->channel_data[b].spectrum;
+  GstFFTF32Complex *cross = cepstrum->tdoa_cross;
+  gfloat *corr = cepstrum->tdoa_corr;
+
+  /* cross power spectrum with phase transform weighting */
+  for (k = 0; k < fft_size; k++) {
+    gfloat re = xa[k].r * xb[k].r + xa[k].i * xb[k].i;
+    gfloat im = xa[k].i * xb[k].r - xa[k].r * xb[k].i;
+    gfloat mag = sqrtf (re * re + im * im);
+
+    if (mag > 1e-20f) {
+      cross[k].r = re / mag;
+      cross[k].i = im / mag;
+    } else {
+      cross[k].r = cross[k].i = 0.0f;
+    }
+  }
+  gst_fft_f32_inverse_fft (cepstrum->tdoa_ctx, cross, corr);
+#endif
+
+  /* peak of the correlation, negative lags wrap around */
+  for (lag = -(gint) max_lag; lag <= (gint) max_lag; lag++) {
+    gdouble v = corr[(lag + nfft) % nfft];
+
+    if (v > best) {
+      best = v;
+      peak = lag;
+    }
+  }
+
+  /* parabolic interpolation around the peak */
+  y0 = corr[(peak - 1 + nfft) % nfft];
+  y1 = corr[(peak + nfft) % nfft];
+  y2 = corr[(peak + 1 + nfft) % nfft];
+  denom = y0 - 2 * y1 + y2;
+  if (denom < 0.0)
+    return peak + 0.5 * (y0 - y2) / denom;
+
+  return peak;
 }
 
 static void
-gst_cepstrum_message_add_array (GValue * cv, gfloat * data, guint num_values)
+gst_cepstrum_tdoa_process (GstCepstrum * cepstrum, GstClockTime timestamp)
 {
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (cepstrum);
+  guint rate = GST_AUDIO_FILTER_RATE (cepstrum);
+  guint nfft = 2 * cepstrum->fft_size - 2;
+  guint max_lag = nfft / 2 - 1;
+  GValue delays = { 0, };
   GValue v = { 0, };
-  GValue a = { 0, };
+  GstStructure *s;
   guint i;
 
-  g_value_init (&a, GST_TYPE_ARRAY);
+  if (cepstrum->tdoa_max_delay > 0)
+    max_lag = MIN (max_lag,
+        gst_util_uint64_scale_ceil (cepstrum->tdoa_max_delay, rate,
+            GST_SECOND));
 
+  g_value_init (&delays, GST_TYPE_ARRAY);
   g_value_init (&v, G_TYPE_FLOAT);
-  for (i = 0; i < num_values; i++) {
-    g_value_set_float (&v, data[i]);
-    gst_value_array_append_value (&a, &v);      /* copies by value */
+  for (i = 0; i < cepstrum->tdoa_num_pairs; i++) {
+    gfloat lag = gst_cepstrum_tdoa_estimate (cepstrum,
+        cepstrum->tdoa_channels[2 * i], cepstrum->tdoa_channels[2 * i + 1],
+        max_lag);
+
+    cepstrum->tdoa_delays[i] = lag / rate;
+    g_value_set_float (&v, cepstrum->tdoa_delays[i]);
+    gst_value_array_append_value (&delays, &v);
   }
   g_value_unset (&v);
 
-  gst_value_array_append_value (cv, &a);        /* copies by value */
-  g_value_unset (&a);
+  s = gst_structure_new ("cepstrum-tdoa",
+      "timestamp", G_TYPE_UINT64, timestamp,
+      "running-time", G_TYPE_UINT64,
+      gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
+          timestamp), NULL);
+  gst_structure_take_value (s, "delays", &delays);
+
+  gst_cepstrum_post_message (cepstrum,
+      gst_message_new_element (GST_OBJECT (cepstrum), s));
 }
 
-static GstMessage *
-gst_cepstrum_message_new  (GstCepstrum * cepstrum, GstClockTime timestamp,
-    GstClockTime duration)
+static void
+gst_cepstrum_onset_detect (GstCepstrum * cepstrum, const gfloat * bands,
+    GstClockTime timestamp)
 {
   GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (cepstrum);
-  GstCepstrumChannel *cd;
+  guint64 onset_ts;
+  gfloat strength;
   GstStructure *s;
-  GValue *mcv = NULL;
-  GstClockTime endtime, running_time, stream_time;
-
-  GST_DEBUG_OBJECT (cepstrum,
-      "preparing message, coeffs =%d bands =%d",
-      cepstrum->num_coeffs, cepstrum->fft_size);
-
-  running_time = gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
-      timestamp);
-  stream_time = gst_segment_to_stream_time (&trans->segment, GST_FORMAT_TIME,
-      timestamp);
-  /* endtime is for backwards compatibility */
-  endtime = stream_time + duration;
 
-  s = gst_structure_new ("cepstrum",
-      "endtime", GST_TYPE_CLOCK_TIME, endtime,
-      "timestamp", G_TYPE_UINT64, timestamp,
-      "stream-time", G_TYPE_UINT64, stream_time,
-      "running-time", G_TYPE_UINT64, running_time,
-      "duration", G_TYPE_UINT64, duration, NULL);
+  if (!gst_cepstrum_onset_push (cepstrum->onset, bands, timestamp,
+          cepstrum->onset_threshold, &onset_ts, &strength))
+    return;
 
-  if (!cepstrum->multi_channel) {
-    cd = &cepstrum->channel_data[0];
+  s = gst_structure_new ("cepstrum-onset",
+      "timestamp", G_TYPE_UINT64, onset_ts,
+      "running-time", G_TYPE_UINT64,
+      gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
+          onset_ts),
+      "strength", G_TYPE_FLOAT, strength, NULL);
 
-      /* FIXME 0.11: this should be an array, not a list */
-      mcv = gst_cepstrum_message_add_container (s, GST_TYPE_LIST, "coeffs");
-      gst_cepstrum_message_add_list (mcv, cd->mfcc, cepstrum->num_coeffs);
-  } else {
-    guint c;
-    guint channels = GST_AUDIO_FILTER_CHANNELS (cepstrum);
+  gst_cepstrum_post_message (cepstrum,
+      gst_message_new_element (GST_OBJECT (cepstrum), s));
+}
 
-    mcv = gst_cepstrum_message_add_container (s, GST_TYPE_ARRAY, "coeffs");
-    for (c = 0; c < channels; c++) {
-      cd = &cepstrum->channel_data[c];
-      gst_cepstrum_message_add_array (mcv, cd->mfcc,
-          cepstrum->num_coeffs);
+/* add the log band energies of a frame to the band envelopes and post the
+ * modulation spectra of all bands once the next one is due */
+static void
+gst_cepstrum_modulation_push (GstCepstrum * cepstrum, const gfloat * bands,
+    GstClockTime timestamp)
+{
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (cepstrum);
+  guint num_bands = cepstrum->num_filters;
+  guint len = cepstrum->mod_len;
+  guint num_bins = cepstrum->mod_bins;
+  gdouble scale = gst_cepstrum_power_scale (len);
+  GstClockTime duration;
+  GstStructure *s;
+  GstBuffer *power;
+  guint b, i;
+
+  for (b = 0; b < num_bands; b++)
+    cepstrum->mod_history[(gsize) b * len + cepstrum->mod_pos] = bands[b];
+  cepstrum->mod_pos = (cepstrum->mod_pos + 1) % len;
+  cepstrum->mod_count = MIN (cepstrum->mod_count + 1, len);
+
+  if (cepstrum->mod_todo > 0)
+    cepstrum->mod_todo--;
+  if (cepstrum->mod_count < len || cepstrum->mod_todo > 0)
+    return;
+  cepstrum->mod_todo = cepstrum->modulation_hop ?
+      cepstrum->modulation_hop : len;
+
+  /* unroll the rings oldest frame first, without the mean of each band */
+  for (b = 0; b < num_bands; b++) {
+    const gfloat *ring = cepstrum->mod_history + (gsize) b * len;
+    guint head = len - cepstrum->mod_pos;
+    gdouble mean = 0.0;
+
+    for (i = 0; i < len; i++)
+      mean += ring[i];
+    mean /= len;
+
+    for (i = 0; i < len; i++) {
+      gfloat v = i < head ? ring[cepstrum->mod_pos + i] : ring[i - head];
+
+      cepstrum->mod_in[(gsize) b * len + i] =
+          (v - mean) * cepstrum->mod_window[i];
     }
   }
-  return gst_message_new_element (GST_OBJECT (cepstrum), s);
+
+#ifdef HAVE_LIBFFTW
+  fftw_execute (cepstrum->mod_plan);
+  for (i = 0; i < num_bands * num_bins; i++)
+    cepstrum->mod_power[i] = (cepstrum->mod_out[i][0] *
+        cepstrum->mod_out[i][0] + cepstrum->mod_out[i][1] *
+        cepstrum->mod_out[i][1]) / scale;
+#else
+  for (b = 0; b < num_bands; b++)
+    gst_fft_f32_fft (cepstrum->mod_ctx, cepstrum->mod_in + (gsize) b * len,
+        cepstrum->mod_out + (gsize) b * num_bins);
+  for (i = 0; i < num_bands * num_bins; i++)
+    cepstrum->mod_power[i] = (cepstrum->mod_out[i].r *
+        cepstrum->mod_out[i].r + cepstrum->mod_out[i].i *
+        cepstrum->mod_out[i].i) / scale;
+#endif
+
+  duration = gst_util_uint64_scale ((guint64) len * cepstrum->hop_len,
+      GST_SECOND, GST_AUDIO_FILTER_RATE (cepstrum));
+  power = gst_buffer_new_memdup (cepstrum->mod_power,
+      (gsize) num_bands * num_bins * sizeof (gfloat));
+
+  s = gst_structure_new ("cepstrum-modulation",
+      "timestamp", G_TYPE_UINT64, timestamp,
+      "running-time", G_TYPE_UINT64,
+      gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
+          timestamp),
+      "duration", G_TYPE_UINT64, duration,
+      "num-bands", G_TYPE_UINT, num_bands,
+      "num-bins", G_TYPE_UINT, num_bins,
+      "bin-width", G_TYPE_FLOAT, (gfloat) GST_AUDIO_FILTER_RATE (cepstrum) /
+      ((gdouble) cepstrum->hop_len * len),
+      "power", GST_TYPE_BUFFER, power, NULL);
+  gst_buffer_unref (power);
+
+  gst_cepstrum_post_message (cepstrum,
+      gst_message_new_element (GST_OBJECT (cepstrum), s));
 }
 
 static void
-pre_emphasis (gfloat *data, gint size, gfloat alpha)
+gst_cepstrum_fingerprint_post (GstCepstrum * cepstrum)
 {
-  for (guint i = size - 1; i > 0; i--) {
-      data[i] = data[i] - alpha * data[i - 1];
-  } 
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (cepstrum);
+  const GstCepstrumLandmark *landmarks;
+  GstClockTime timestamp;
+  guint32 *records;
+  guint i, num_landmarks;
+  GstStructure *s;
+  GstBuffer *hashes;
+
+  landmarks = gst_cepstrum_fingerprint_get_landmarks (cepstrum->fp,
+      &num_landmarks);
+  if (num_landmarks == 0)
+    return;
+
+  timestamp = landmarks[0].timestamp;
+  records = g_new (guint32, 2 * num_landmarks);
+  for (i = 0; i < num_landmarks; i++) {
+    records[2 * i] = landmarks[i].hash;
+    records[2 * i + 1] = GST_CLOCK_TIME_IS_VALID (timestamp) ?
+        (landmarks[i].timestamp - timestamp) / GST_USECOND : 0;
+  }
+  hashes = gst_buffer_new_wrapped (records,
+      2 * num_landmarks * sizeof (guint32));
+  gst_cepstrum_fingerprint_clear_landmarks (cepstrum->fp);
+
+  s = gst_structure_new ("cepstrum-fingerprint",
+      "timestamp", G_TYPE_UINT64, timestamp,
+      "running-time", G_TYPE_UINT64,
+      gst_segment_to_running_time (&trans->segment, GST_FORMAT_TIME,
+          timestamp),
+      "num-hashes", G_TYPE_UINT, num_landmarks,
+      "hashes", GST_TYPE_BUFFER, hashes, NULL);
+  gst_buffer_unref (hashes);
+
+  gst_cepstrum_post_message (cepstrum,
+      gst_message_new_element (GST_OBJECT (cepstrum), s));
 }
 
 static void
-hamming_window (gfloat *data, guint size)
+gst_cepstrum_history_push (GstCepstrum * cepstrum, const gfloat * features,
+    GstClockTime timestamp)
 {
-  for (guint i = 0; i < size; ++i) {
-      data[i] *= (0.54 - 0.46 * cos ((2 * G_PI * i) / (size - 1)));
-  }
+  guint pos = cepstrum->history_pos;
+
+  memcpy (cepstrum->history + (gsize) pos * cepstrum->frame_len, features,
+      cepstrum->frame_len * sizeof (gfloat));
+  cepstrum->history_ts[pos] = timestamp;
+
+  cepstrum->history_pos = (pos + 1) % cepstrum->history_size;
+  if (cepstrum->history_len < cepstrum->history_size)
+    cepstrum->history_len++;
 }
 
-static void
-compute_dct (gfloat *in, gfloat *out, guint size)
+static GstBuffer *
+gst_cepstrum_get_history (GstCepstrum * cepstrum, guint64 duration)
 {
-  for (guint k = 0; k < size; k++) {
-      out[k] = 0.0;
-      for (guint n = 0; n < size; n++) {
-          out[k] += in[n] * cos (G_PI * k * (n + 0.5) / size);
-      }
+  GstBuffer *buffer = NULL;
+  guint size, last, first, n, num_frames;
+  gsize frame_bytes;
+  GstClockTime last_ts;
+
+  g_mutex_lock (&cepstrum->lock);
+
+  if (cepstrum->history_len == 0)
+    goto done;
 
-      /* orthogonalization */
-      if (k == 0)
-        out[k] *= sqrt (1.0 / size);
-      else
-        out[k] *= sqrt (2.0 / size);
+  size = cepstrum->history_size;
+  last = (cepstrum->history_pos + size - 1) % size;
+  last_ts = cepstrum->history_ts[last];
+
+  /* walk back from the newest frame while it is within @duration */
+  num_frames = 1;
+  if (duration == 0 || !GST_CLOCK_TIME_IS_VALID (last_ts)) {
+    num_frames = cepstrum->history_len;
+  } else {
+    while (num_frames < cepstrum->history_len) {
+      GstClockTime ts =
+          cepstrum->history_ts[(last + size - num_frames) % size];
+
+      if (!GST_CLOCK_TIME_IS_VALID (ts) || last_ts - ts > duration)
+        break;
+      num_frames++;
+    }
   }
+  first = (last + size + 1 - num_frames) % size;
+
+  frame_bytes = cepstrum->frame_len * sizeof (gfloat);
+  buffer = gst_buffer_new_allocate (NULL, num_frames * frame_bytes, NULL);
+
+  /* the ring may wrap, copy in at most two pieces */
+  n = MIN (num_frames, size - first);
+  gst_buffer_fill (buffer, 0, cepstrum->history + (gsize) first *
+      cepstrum->frame_len, n * frame_bytes);
+  if (n < num_frames)
+    gst_buffer_fill (buffer, n * frame_bytes, cepstrum->history,
+        (num_frames - n) * frame_bytes);
+
+  GST_BUFFER_PTS (buffer) = cepstrum->history_ts[first];
+  if (GST_CLOCK_TIME_IS_VALID (cepstrum->history_ts[first]) &&
+      GST_CLOCK_TIME_IS_VALID (last_ts))
+    GST_BUFFER_DURATION (buffer) = last_ts - cepstrum->history_ts[first];
+
+done:
+  g_mutex_unlock (&cepstrum->lock);
+
+  return buffer;
 }
 
-static inline gfloat hz_to_mel(gfloat hz)
+/* the log band energies of the last frame of @cd: its log Mel energies, or
+ * the log gammatone energies in PNCC mode */
+static inline const gfloat *
+gst_cepstrum_log_bands (GstCepstrumChannel * cd)
 {
-  return 2595.0 * log10f (1.0 + hz / 700.0);
+  return cd->log_bands ? cd->log_bands : cd->mel;
 }
 
-static inline gfloat mel_to_hz(gfloat mel)
+/* called once per analysis frame, after gst_cepstrum_frame_features has run
+ * on every output channel. @on_hop is %FALSE for frames off the hop grid */
+static void
+gst_cepstrum_frame_done (GstCepstrum * cepstrum, GstClockTime timestamp,
+    gboolean on_hop)
 {
-  return 700.0 * (powf (10.0, mel / 2595.0) - 1.0);
+  guint num_coeffs = cepstrum->num_coeffs;
+  gfloat *features = cepstrum->features;
+  guint c;
+
+  for (c = 0; c < cepstrum->num_channels; c++)
+    memcpy (features + c * num_coeffs, cepstrum->channel_data[c].mfcc,
+        num_coeffs * sizeof (gfloat));
+
+  /* emitted by gst_cepstrum_emit_features once the lock is released */
+  if (cepstrum->emit_signals) {
+    g_array_append_vals (cepstrum->signal_features, features,
+        cepstrum->frame_len);
+    g_array_append_val (cepstrum->signal_ts, timestamp);
+  }
+
+  if (cepstrum->history)
+    gst_cepstrum_history_push (cepstrum, features, timestamp);
+
+  if (cepstrum->scorer_handle) {
+    if (cepstrum->scorer_pending == 0)
+      cepstrum->scorer_ts = timestamp;
+    memcpy (cepstrum->scorer_frames +
+        cepstrum->scorer_pending * cepstrum->frame_len, features,
+        cepstrum->frame_len * sizeof (gfloat));
+    if (++cepstrum->scorer_pending == cepstrum->scorer_batch)
+      gst_cepstrum_scorer_run (cepstrum);
+  }
+
+  if (cepstrum->gmm_active)
+    gst_cepstrum_gmm_classify (cepstrum, features, timestamp);
+
+  if (cepstrum->dtw_active)
+    gst_cepstrum_dtw_match (cepstrum, features, timestamp);
+
+  if (cepstrum->lsh_active && cepstrum->lsh_per_frame)
+    gst_cepstrum_lsh_lookup (cepstrum, features, timestamp);
+
+  if (cepstrum->tdoa_num_pairs)
+    gst_cepstrum_tdoa_process (cepstrum, timestamp);
+
+  /* in multi-channel mode onsets are detected on the first channel */
+  if (cepstrum->onset)
+    gst_cepstrum_onset_detect (cepstrum,
+        gst_cepstrum_log_bands (&cepstrum->channel_data[0]), timestamp);
+
+  /* in multi-channel mode the first channel is fingerprinted */
+  if (cepstrum->fp)
+    gst_cepstrum_fingerprint_push (cepstrum->fp,
+        cepstrum->channel_data[0].power, timestamp);
+
+  /* and its envelopes give the modulation spectra, sampled at the hop */
+  if (cepstrum->mod_len && on_hop)
+    gst_cepstrum_modulation_push (cepstrum,
+        gst_cepstrum_log_bands (&cepstrum->channel_data[0]), timestamp);
 }
 
+/* called once per interval with the coefficients of its averaged spectrum */
 static void
-alloc_mel_filterbank (gfloat **fbank, gint nfilts,
-                gint sample_rate, gint nfft)
+gst_cepstrum_interval_done (GstCepstrum * cepstrum, GstClockTime timestamp,
+    guint num_fft)
 {
-  gfloat *bin = g_malloc0 ((nfilts + 2) * sizeof(gfloat));
-
-  gfloat lowmel = hz_to_mel (0.0);
-  gfloat highmel = hz_to_mel (sample_rate / 2.0);
-  gfloat mel_step = (highmel - lowmel) / (nfilts + 1);
+  GstCepstrumChannel *cd;
+  guint c;
 
-  /* calculate Mel center frequencies and convert to FFT bin numbers */
-  for (guint i = 0; i <= nfilts + 1; i++) {
-    bin[i] = mel_to_hz (lowmel + i * mel_step);
-    bin[i] = floor ((nfft + 1) * bin[i] / sample_rate);
+  for (c = 0; c < cepstrum->num_channels; c++) {
+    cd = &cepstrum->channel_data[c];
+    gst_cepstrum_prepare_message_data (cepstrum, cd, num_fft);
   }
 
-  /* create triangular filters */
-  for (gint i = 0; i <= nfilts; i++) {
-    fbank[i] = g_malloc0 (nfft * sizeof (gfloat));
-    for (gint k = 0; k < nfft; k++)
-      fbank[i][k] = 0.0f;
-    for (guint k = bin[i]; k < bin[i+1]; k++)
-        fbank[i][k] = (k - bin[i]) / (bin[i+1] - bin[i]);
-    for (guint k = bin[i+1]; k < bin[i+2]; k++)
-        fbank[i][k] = (bin[i+2] - k) / (bin[i+2] - bin[i+1]);
+  if (cepstrum->post_messages && gst_cepstrum_message_changed (cepstrum)) {
+    GstMessage *m;
+
+    m = gst_cepstrum_message_new (cepstrum, timestamp, cepstrum->interval);
+
+    gst_cepstrum_post_message (cepstrum, m);
   }
 
-  g_free (bin);
+  if (cepstrum->lsh_active && !cepstrum->lsh_per_frame)
+    gst_cepstrum_lsh_lookup (cepstrum, cepstrum->channel_data[0].mfcc,
+        timestamp);
+
+  if (cepstrum->fp)
+    gst_cepstrum_fingerprint_post (cepstrum);
+
+  for (c = 0; c < cepstrum->num_channels; c++) {
+    cd = &cepstrum->channel_data[c];
+    gst_cepstrum_reset_message_data (cepstrum, cd);
+  }
 }
 
 static void
-free_mel_filterbank (gfloat **fbank, gint nfilts)
+gst_cepstrum_analyse_slots (GstCepstrum * cepstrum, guint first, guint last)
 {
-    for (guint i = 0; i < nfilts; i++) {
-        g_free (fbank[i]);
-    }
+  guint slot, c;
+
+  for (slot = first; slot < last; slot++)
+    for (c = 0; c < cepstrum->num_channels; c++)
+      gst_cepstrum_frame_spectrum (cepstrum, &cepstrum->channel_data[c], slot);
 }
 
 static void
-compute_mel_filterbank (gfloat *in, gfloat *out, gfloat **fbank, guint nfilts,
-          guint nfft)
+gst_cepstrum_analysis_func (gpointer data, gpointer user_data)
 {
-    for (guint i = 0; i < nfilts; i++) {
-        out[i] = 0.0;
-        for (guint j = 0; j < nfft / 2; j++) {
-            out[i] += in[j] * fbank[i][j];
-        }
-        out[i] = log (fmaxf (out[i], 1e-10));
-    }
+  GstCepstrumJob *job = data;
+  GstCepstrum *cepstrum = job->cepstrum;
+
+  gst_cepstrum_analyse_slots (cepstrum, job->first, job->last);
+
+  g_mutex_lock (&cepstrum->jobs_lock);
+  if (--cepstrum->jobs_pending == 0)
+    g_cond_signal (&cepstrum->jobs_cond);
+  g_mutex_unlock (&cepstrum->jobs_lock);
 }
 
+/* compute the spectra of the queued frames, in parallel if possible, then
+ * deliver the frames and intervals in stream order */
 static void
-gst_cepstrum_fft (GstCepstrum * cepstrum, GstCepstrumChannel * cd)
+gst_cepstrum_run_batch (GstCepstrum * cepstrum)
 {
-  guint fft_size = cepstrum->fft_size;
-  guint nfft = 2 * fft_size - 2;
-  gfloat *spect_magnitude = cd->spect_magnitude;
-  gdouble val;
-#ifdef HAVE_LIBFFTW
-  fftw_complex *fftdata = cd->fftdata;
-  fftw_plan fftplan = cd->fftplan;
+  guint num_queued = cepstrum->num_queued;
+  guint threads = MIN (cepstrum->num_threads, num_queued);
+  guint slot, c, t, per_job, i = 0;
+
+  GST_CEPSTRUM_PROBE2 (batch_start, cepstrum, num_queued);
+
+  if (cepstrum->use_sdft) {
+    /* the spectra were taken from the sliding DFT when queueing */
+  } else if (cepstrum->pool && threads > 1) {
+    per_job = (num_queued + threads - 1) / threads;
+    threads = (num_queued + per_job - 1) / per_job;
+
+    cepstrum->jobs_pending = threads - 1;
+    for (t = 1; t < threads; t++) {
+      GstCepstrumJob *job = &cepstrum->jobs[t];
+
+      job->cepstrum = cepstrum;
+      job->first = t * per_job;
+      job->last = MIN (num_queued, (t + 1) * per_job);
+      g_thread_pool_push (cepstrum->pool, job, NULL);
+    }
+    gst_cepstrum_analyse_slots (cepstrum, 0, per_job);
 
-  fftw_execute (fftplan);
+    g_mutex_lock (&cepstrum->jobs_lock);
+    while (cepstrum->jobs_pending > 0)
+      g_cond_wait (&cepstrum->jobs_cond, &cepstrum->jobs_lock);
+    g_mutex_unlock (&cepstrum->jobs_lock);
+  } else {
+    gst_cepstrum_analyse_slots (cepstrum, 0, num_queued);
+  }
 
-  /* compute power spectrum */
-  for (guint i = 0; i < fft_size; i++) {
-    val = fftdata[i][0] * fftdata[i][0];
-    val += fftdata[i][1] * fftdata[i][1];
-    val /= nfft;
-    spect_magnitude[i] += val;
+  for (slot = 0; slot < num_queued; slot++) {
+    for (; i < cepstrum->num_intervals && cepstrum->intervals[i].after == slot;
+        i++)
+      gst_cepstrum_interval_done (cepstrum, cepstrum->intervals[i].timestamp,
+          cepstrum->intervals[i].num_fft);
+
+    GST_CEPSTRUM_PROBE3 (frame_start, cepstrum, cepstrum->frame_index,
+        cepstrum->slot_ts[slot]);
+    for (c = 0; c < cepstrum->num_channels; c++)
+      gst_cepstrum_frame_features (cepstrum, &cepstrum->channel_data[c],
+          slot);
+    gst_cepstrum_frame_done (cepstrum, cepstrum->slot_ts[slot],
+        cepstrum->slot_on_hop[slot]);
+    GST_CEPSTRUM_PROBE3 (frame_end, cepstrum, cepstrum->frame_index,
+        cepstrum->slot_ts[slot]);
+    cepstrum->frame_index++;
   }
-#else
-  gfloat *input_tmp = cd->input_tmp;
-  GstFFTF32Complex *fftdata = cd->fftdata;
-  GstFFTF32 *fft_ctx = cd->fft_ctx;
+  for (; i < cepstrum->num_intervals; i++)
+    gst_cepstrum_interval_done (cepstrum, cepstrum->intervals[i].timestamp,
+        cepstrum->intervals[i].num_fft);
 
-  //gst_fft_f32_window (fft_ctx, input_tmp, GST_FFT_WINDOW_HAMMING);
-  gst_fft_f32_fft (fft_ctx, input_tmp, fftdata);
+  GST_CEPSTRUM_PROBE2 (batch_end, cepstrum, num_queued);
 
-  /* compute power spectrum */
-  for (guint i = 0; i < fft_size; i++) {
-    val = fftdata[i].r * fftdata[i].r;
-    val += fftdata[i].i * fftdata[i].i;
-    val /= nfft * nfft;
-    spect_magnitude[i] += val;
-  }
-#endif
+  cepstrum->num_queued = 0;
+  cepstrum->num_intervals = 0;
 }
 
+/* feed the @len samples just written to the ring at @input_pos to the
+ * sliding DFT; they are already pre-filtered */
 static void
-gst_cepstrum_run_mfcc (GstCepstrum *cepstrum, GstCepstrumChannel *cd,
-    guint input_pos)
+gst_cepstrum_sdft_feed (GstCepstrum * cepstrum, GstCepstrumChannel * cd,
+    guint input_pos, guint len)
 {
-  guint i;
-  guint frame_size = cepstrum->win_size;
-  guint fft_size = cepstrum->fft_size;
-  guint nfft = 2 * fft_size - 2;
-  guint nfilts = cepstrum->num_filters;
-  gfloat *input = cd->input;
-  gfloat *input_tmp = cd->input_tmp;
-  gfloat *spect_magnitude = cd->spect_magnitude;
-  gfloat *mfcc = cd->mfcc;
-  gfloat **fbank = cepstrum->filter_bank;
-  guint numcoeffs = cepstrum->num_coeffs;
-  gfloat alpha = cepstrum->preemphasis_coeff;
-  gboolean use_preemphasis = cepstrum->use_preemphasis;
-
-  for (i = 0; i < frame_size; i++)
-    input_tmp[i] = input[(input_pos + i) % frame_size];
+  guint first = MIN (len, cepstrum->win_len - input_pos);
 
-  if (use_preemphasis)
-    pre_emphasis (input_tmp, frame_size, alpha);
+  gst_cepstrum_sdft_push (cd->sdft, cd->input + input_pos, first);
+  if (first < len)
+    gst_cepstrum_sdft_push (cd->sdft, cd->input, len - first);
+}
 
-  /* apply hamming window to input data */
-  hamming_window (input_tmp, frame_size);
+/* queue the frame ending at @input_pos, the batch runs once it is full.
+ * @on_hop is %FALSE for the extra frame of an interval that had none */
+static void
+gst_cepstrum_queue_frame (GstCepstrum * cepstrum, guint input_pos,
+    GstClockTime timestamp, gboolean on_hop)
+{
+  guint slot = cepstrum->num_queued++;
+  guint nfft = 2 * cepstrum->fft_size - 2;
+  guint c;
 
-  /* run FFT */
-  gst_cepstrum_fft (cepstrum, cd);
+  for (c = 0; c < cepstrum->num_channels; c++) {
+    GstCepstrumChannel *cd = &cepstrum->channel_data[c];
 
-  /* apply Mel filterbank */
-  compute_mel_filterbank (spect_magnitude, mfcc, fbank, nfilts, nfft);
+    if (cd->sdft)
+      gst_cepstrum_sdft_power (cd->sdft, cd->frame_power + (gsize) slot *
+          (cepstrum->bin_hi - cepstrum->bin_lo), cepstrum->bin_lo,
+          gst_cepstrum_power_scale (nfft));
+    else
+      gst_cepstrum_frame_copy (cepstrum, cd, input_pos, slot);
+  }
+  cepstrum->slot_ts[slot] = timestamp;
+  cepstrum->slot_on_hop[slot] = on_hop;
 
-  /* apply DCT to Mel coefficients to get MFCCs */
-  compute_dct (mfcc, mfcc, numcoeffs);
+  if (cepstrum->num_queued == cepstrum->num_slots)
+    gst_cepstrum_run_batch (cepstrum);
 }
 
+/* queue the end of an interval behind the frames already queued */
 static void
-gst_cepstrum_prepare_message_data (GstCepstrum * cepstrum,
-    GstCepstrumChannel * cd)
+gst_cepstrum_queue_interval (GstCepstrum * cepstrum, GstClockTime timestamp,
+    guint num_fft)
 {
-  guint i;
-  guint fft_size = cepstrum->fft_size;
-  guint num_fft = cepstrum->num_fft;
-  gfloat *spect_magnitude = cd->spect_magnitude;
+  GstCepstrumInterval *interval;
 
-  /* Calculate average */
-  for (i = 0; i < fft_size; i++) {
-    spect_magnitude[i] /= num_fft;
+  if (cepstrum->num_intervals == cepstrum->num_slots)
+    gst_cepstrum_run_batch (cepstrum);
+
+  if (cepstrum->num_queued == 0) {
+    gst_cepstrum_interval_done (cepstrum, timestamp, num_fft);
+    return;
   }
+
+  interval = &cepstrum->intervals[cepstrum->num_intervals++];
+  interval->after = cepstrum->num_queued;
+  interval->timestamp = timestamp;
+  interval->num_fft = num_fft;
 }
 
+/* length of the next interval, spreading the rounding error */
 static void
-gst_cepstrum_reset_message_data (GstCepstrum * cepstrum,
-    GstCepstrumChannel * cd)
+gst_cepstrum_next_interval (GstCepstrum * cepstrum)
 {
-  guint fft_size = cepstrum->fft_size;
-  guint mfcc_size = cepstrum->num_coeffs;
-  gfloat *spect_magnitude = cd->spect_magnitude;
-  gfloat *mfcc = cd->mfcc;
+  cepstrum->frames_todo = cepstrum->frames_per_interval;
+  if (cepstrum->accumulated_error >= GST_SECOND) {
+    cepstrum->accumulated_error -= GST_SECOND;
+    cepstrum->frames_todo++;
+  }
+  cepstrum->accumulated_error += cepstrum->error_per_interval;
+}
 
-  /* reset accumulators */
-  memset (spect_magnitude, 0, fft_size * sizeof (gfloat));
-  memset (mfcc, 0, mfcc_size * sizeof (gfloat));
+/* whether anything would see the result of the analysis */
+static gboolean
+gst_cepstrum_has_consumers (GstCepstrum * cepstrum)
+{
+  return cepstrum->post_messages || cepstrum->emit_signals ||
+      cepstrum->history || cepstrum->scorer_handle ||
+      cepstrum->gmm_active || cepstrum->dtw_active || cepstrum->lsh_active ||
+      cepstrum->fp || cepstrum->onset || cepstrum->tdoa_num_pairs ||
+      cepstrum->mod_len;
+}
+
+/* emit new-features for the frames collected by gst_cepstrum_frame_done,
+ * without the element lock so that handlers can use the element. The
+ * frames are only touched by the streaming thread */
+static void
+gst_cepstrum_emit_features (GstCepstrum * cepstrum, guint num_channels,
+    guint num_coeffs)
+{
+  gsize frame_len = (gsize) num_channels * num_coeffs;
+  guint i;
+
+  for (i = 0; i < cepstrum->signal_ts->len; i++)
+    g_signal_emit (cepstrum, gst_cepstrum_signals[SIGNAL_NEW_FEATURES], 0,
+        &g_array_index (cepstrum->signal_features, gfloat, i * frame_len),
+        num_channels, num_coeffs,
+        g_array_index (cepstrum->signal_ts, GstClockTime, i));
+
+  g_array_set_size (cepstrum->signal_features, 0);
+  g_array_set_size (cepstrum->signal_ts, 0);
 }
 
 static GstFlowReturn
@@ -997,17 +4758,17 @@ gst_cepstrum_transform_ip (GstBaseTransform * trans, GstBuffer * buffer)
   guint output_channels = cepstrum->multi_channel ? channels : 1;
   guint c;
   gfloat max_value = (1UL << ((bps << 3) - 1)) - 1;
-  guint fft_size = cepstrum->fft_size;
-  guint nfft = 2 * fft_size - 2;
   guint input_pos;
   gfloat *input;
   GstMapInfo map;
   const guint8 *data;
   gsize size;
   guint fft_todo, msg_todo, block_size;
-  gboolean have_full_interval;
+  gboolean have_full_interval, have_full_hop;
+  gboolean active, per_frame;
   GstCepstrumChannel *cd;
   GstCepstrumInputData input_data;
+  guint num_channels, num_coeffs;
 
   g_mutex_lock (&cepstrum->lock);
   gst_buffer_map (buffer, &map, GST_MAP_READ);
@@ -1015,9 +4776,14 @@ gst_cepstrum_transform_ip (GstBaseTransform * trans, GstBuffer * buffer)
   size = map.size;
 
   GST_LOG_OBJECT (cepstrum, "input size: %" G_GSIZE_FORMAT " bytes", size);
+  GST_CEPSTRUM_PROBE4 (buffer_start, cepstrum, GST_BUFFER_TIMESTAMP (buffer),
+      GST_BUFFER_DURATION (buffer), size / bpf);
 
   if (GST_BUFFER_IS_DISCONT (buffer)) {
     GST_DEBUG_OBJECT (cepstrum, "Discontinuity detected -- flushing");
+    if (cepstrum->scorer_pending > 0)
+      gst_cepstrum_scorer_run (cepstrum);
+    gst_cepstrum_dtw_drain (cepstrum);
     gst_cepstrum_flush (cepstrum);
   }
 
@@ -1025,7 +4791,8 @@ gst_cepstrum_transform_ip (GstBaseTransform * trans, GstBuffer * buffer)
    * changes) get one and allocate memory for everything
    */
   if (cepstrum->channel_data == NULL) {
-    GST_DEBUG_OBJECT (cepstrum, "allocating for bands %u", fft_size);
+    GST_DEBUG_OBJECT (cepstrum, "allocating for bands %u",
+        cepstrum->fft_size);
 
     gst_cepstrum_alloc_channel_data (cepstrum);
 
@@ -1040,25 +4807,77 @@ gst_cepstrum_transform_ip (GstBaseTransform * trans, GstBuffer * buffer)
     if (cepstrum->frames_per_interval == 0)
       cepstrum->frames_per_interval = 1;
 
+    /* one sample and one window of the sample clock */
+    cepstrum->sample_ns = GST_SECOND / rate;
+    cepstrum->sample_rem = GST_SECOND % rate;
+    cepstrum->window_ns = (cepstrum->win_len * GST_SECOND) / rate;
+    cepstrum->window_rem = (cepstrum->win_len * GST_SECOND) % rate;
+
     GST_INFO_OBJECT (cepstrum, "interval %" GST_TIME_FORMAT ", fpi %"
         G_GUINT64_FORMAT ", error %" GST_TIME_FORMAT,
         GST_TIME_ARGS (cepstrum->interval), cepstrum->frames_per_interval,
         GST_TIME_ARGS (cepstrum->error_per_interval));
 
     cepstrum->input_pos = 0;
+    cepstrum->idle = FALSE;
 
     gst_cepstrum_flush (cepstrum);
   }
 
-  if (cepstrum->num_frames == 0)
-    cepstrum->message_ts = GST_BUFFER_TIMESTAMP (buffer);
+  /* frames are stamped by counting samples from the first timestamped
+   * buffer after a discontinuity, later timestamps are not looked at */
+  if (!GST_CLOCK_TIME_IS_VALID (cepstrum->clock_ns) &&
+      GST_CLOCK_TIME_IS_VALID (GST_BUFFER_TIMESTAMP (buffer))) {
+    cepstrum->clock_ns = GST_BUFFER_TIMESTAMP (buffer);
+    cepstrum->clock_rem = 0;
+    cepstrum->clock_start = cepstrum->clock_ns;
+    if (cepstrum->num_frames == 0)
+      cepstrum->message_ts = cepstrum->clock_ns;
+  }
+
+  /* without consumers only the sample counters and timestamps advance, so
+   * that intervals stay aligned once somebody is interested again */
+  active = gst_cepstrum_has_consumers (cepstrum);
+  if (!active && !cepstrum->idle) {
+    GST_DEBUG_OBJECT (cepstrum, "no consumers, skipping analysis");
+    /* drop what the current interval accumulated so far, it is not posted
+     * and must not leak into the first interval after resuming */
+    for (c = 0; c < cepstrum->num_channels; c++)
+      gst_cepstrum_reset_message_data (cepstrum, &cepstrum->channel_data[c]);
+    cepstrum->num_fft = 0;
+    cepstrum->idle = TRUE;
+  } else if (active && cepstrum->idle) {
+    GST_DEBUG_OBJECT (cepstrum, "resuming analysis");
+    for (c = 0; c < output_channels; c++) {
+      cd = &cepstrum->channel_data[c];
+      memset (cd->input, 0, cepstrum->win_len * sizeof (gfloat));
+      if (cd->sdft)
+        gst_cepstrum_sdft_reset (cd->sdft);
+      cd->prefilter.x1 = cd->prefilter.y1 = 0.0f;
+    }
+    if (cepstrum->snip_edges)
+      cepstrum->warmup = cepstrum->win_len;
+    cepstrum->idle = FALSE;
+  }
+
+  /* the filter coefficients may change at any time, the state stays. The
+   * presets pre-filter each frame instead, see gst_cepstrum_frame_prefilter */
+  per_frame = (cepstrum->preset != GST_CEPSTRUM_PRESET_NONE);
+  for (c = 0; active && c < output_channels; c++) {
+    cd = &cepstrum->channel_data[c];
+    cd->prefilter.emphasis = cepstrum->use_preemphasis && !per_frame ?
+        cepstrum->preemphasis_coeff : 0.0f;
+    cd->prefilter.dc_pole = cepstrum->remove_dc && !per_frame ?
+        1.0f - 2.0f * G_PI * DC_BLOCK_CUTOFF / rate : 0.0f;
+    cd->prefilter.dither = per_frame ? 0.0f : cepstrum->dither * DITHER_SCALE;
+  }
 
   input_pos = cepstrum->input_pos;
   input_data = cepstrum->input_data;
 
   while (size >= bpf) {
     /* run input_data for a chunk of data */
-    fft_todo = nfft - (cepstrum->num_frames % nfft);
+    fft_todo = cepstrum->hop_len - cepstrum->hop_pos;
     msg_todo = cepstrum->frames_todo - cepstrum->num_frames;
     GST_LOG_OBJECT (cepstrum,
         "message frames todo: %u, fft frames todo: %u, input frames %"
@@ -1068,82 +4887,87 @@ gst_cepstrum_transform_ip (GstBaseTransform * trans, GstBuffer * buffer)
       block_size = (size / bpf);
     if (block_size > fft_todo)
       block_size = fft_todo;
+    /* hops can be longer than the ring, a block never wraps it twice */
+    if (block_size > cepstrum->win_len)
+      block_size = cepstrum->win_len;
 
-    for (c = 0; c < output_channels; c++) {
+    for (c = 0; active && c < output_channels; c++) {
       cd = &cepstrum->channel_data[c];
       input = cd->input;
       /* Move the current frames into our ringbuffers */
       input_data (data + c * bps, input, block_size, channels, max_value,
-          input_pos, nfft);
+          input_pos, cepstrum->win_len, &cd->prefilter);
+      if (cd->sdft)
+        gst_cepstrum_sdft_feed (cepstrum, cd, input_pos, block_size);
     }
     data += block_size * bpf;
     size -= block_size * bpf;
-    input_pos = (input_pos + block_size) % nfft;
+    input_pos = (input_pos + block_size) % cepstrum->win_len;
     cepstrum->num_frames += block_size;
+    cepstrum->hop_pos += block_size;
+    gst_cepstrum_clock_advance (cepstrum, block_size, rate);
+    cepstrum->warmup -= MIN (cepstrum->warmup, block_size);
 
     have_full_interval = (cepstrum->num_frames == cepstrum->frames_todo);
+    have_full_hop = (cepstrum->hop_pos == cepstrum->hop_len);
+    if (have_full_hop)
+      cepstrum->hop_pos = 0;
 
     GST_LOG_OBJECT (cepstrum,
         "size: %" G_GSIZE_FORMAT ", do-fft = %d, do-message = %d", size,
-        (cepstrum->num_frames % nfft == 0), have_full_interval);
+        have_full_hop, have_full_interval);
 
     /* If we have enough frames for an FFT or we have all frames required for
      * the interval and we haven't run a FFT, then run an FFT */
-    if ((cepstrum->num_frames % nfft == 0) ||
-        (have_full_interval && !cepstrum->num_fft)) {
-      for (c = 0; c < output_channels; c++) {
-        cd = &cepstrum->channel_data[c];
-        gst_cepstrum_run_mfcc (cepstrum, cd, input_pos);
-      }
+    if (active && ((have_full_hop && !cepstrum->warmup) ||
+            (have_full_interval && !cepstrum->num_fft))) {
+      gst_cepstrum_queue_frame (cepstrum, input_pos,
+          gst_cepstrum_frame_timestamp (cepstrum), have_full_hop);
       cepstrum->num_fft++;
     }
 
     /* Do we have the FFTs for one interval? */
-    if (have_full_interval) {
-      GST_DEBUG_OBJECT (cepstrum, "nfft: %u frames: %" G_GUINT64_FORMAT
-          " fpi: %" G_GUINT64_FORMAT " error: %" GST_TIME_FORMAT, nfft,
+    if (have_full_interval && !active) {
+      gst_cepstrum_next_interval (cepstrum);
+
+      cepstrum->message_ts = cepstrum->clock_ns;
+      cepstrum->num_frames = 0;
+      cepstrum->num_fft = 0;
+    } else if (have_full_interval) {
+      GST_DEBUG_OBJECT (cepstrum, "hop: %u frames: %" G_GUINT64_FORMAT
+          " fpi: %" G_GUINT64_FORMAT " error: %" GST_TIME_FORMAT,
+          cepstrum->hop_len,
           cepstrum->num_frames, cepstrum->frames_per_interval,
           GST_TIME_ARGS (cepstrum->accumulated_error));
 
-      cepstrum->frames_todo = cepstrum->frames_per_interval;
-      if (cepstrum->accumulated_error >= GST_SECOND) {
-        cepstrum->accumulated_error -= GST_SECOND;
-        cepstrum->frames_todo++;
-      }
-      cepstrum->accumulated_error += cepstrum->error_per_interval;
-
-      if (cepstrum->post_messages) {
-        GstMessage *m;
-
-        for (c = 0; c < output_channels; c++) {
-          cd = &cepstrum->channel_data[c];
-          gst_cepstrum_prepare_message_data (cepstrum, cd);
-        }
-
-        m = gst_cepstrum_message_new (cepstrum, cepstrum->message_ts,
-            cepstrum->interval);
+      gst_cepstrum_next_interval (cepstrum);
 
-        gst_element_post_message (GST_ELEMENT (cepstrum), m);
-      }
+      gst_cepstrum_queue_interval (cepstrum, cepstrum->message_ts,
+          cepstrum->num_fft);
 
-      if (GST_CLOCK_TIME_IS_VALID (cepstrum->message_ts))
-        cepstrum->message_ts +=
-            gst_util_uint64_scale (cepstrum->num_frames, GST_SECOND, rate);
+      /* the next interval starts at the next sample */
+      cepstrum->message_ts = cepstrum->clock_ns;
 
-      for (c = 0; c < output_channels; c++) {
-        cd = &cepstrum->channel_data[c];
-        gst_cepstrum_reset_message_data (cepstrum, cd);
-      }
       cepstrum->num_frames = 0;
       cepstrum->num_fft = 0;
     }
   }
 
+  /* deliver what is left of the batch with this buffer */
+  if (cepstrum->num_queued > 0)
+    gst_cepstrum_run_batch (cepstrum);
+
   cepstrum->input_pos = input_pos;
 
+  GST_CEPSTRUM_PROBE3 (buffer_end, cepstrum, GST_BUFFER_TIMESTAMP (buffer),
+      cepstrum->frame_index);
   gst_buffer_unmap (buffer, &map);
+  num_channels = cepstrum->num_channels;
+  num_coeffs = cepstrum->num_coeffs;
   g_mutex_unlock (&cepstrum->lock);
 
+  gst_cepstrum_emit_features (cepstrum, num_channels, num_coeffs);
+
   g_assert (size == 0);
 
   return GST_FLOW_OK;
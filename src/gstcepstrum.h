@@ -23,6 +23,7 @@
 
 #include <gst/gst.h>
 #include <gst/audio/gstaudiofilter.h>
+#include <gmodule.h>
 
 #ifdef HAVE_LIBFFTW
 #include <fftw3.h>
@@ -30,6 +31,16 @@
 #include <gst/fft/gstfftf32.h>
 #endif
 
+#include "gstcepstrumscorer.h"
+#include "gstcepstrumgmm.h"
+#include "gstcepstrumdtw.h"
+#include "gstcepstrumfingerprint.h"
+#include "gstcepstrumlsh.h"
+#include "gstcepstrumonset.h"
+#include "gstcepstrumnoise.h"
+#include "gstcepstrumsdft.h"
+#include "gstcepstrumpncc.h"
+
 
 G_BEGIN_DECLS
 
@@ -41,23 +52,208 @@ G_BEGIN_DECLS
 typedef struct _GstCepstrum GstCepstrum;
 typedef struct _GstCepstrumClass GstCepstrumClass;
 typedef struct _GstCepstrumChannel GstCepstrumChannel;
+typedef struct _GstCepstrumInterval GstCepstrumInterval;
+typedef struct _GstCepstrumJob GstCepstrumJob;
+typedef struct _GstCepstrumMelFilter GstCepstrumMelFilter;
+typedef struct _GstCepstrumPreFilter GstCepstrumPreFilter;
+typedef struct _GstCepstrumCqtKernel GstCepstrumCqtKernel;
+
+/**
+ * GstCepstrumChangeMetric:
+ * @GST_CEPSTRUM_CHANGE_METRIC_L2: euclidean distance
+ * @GST_CEPSTRUM_CHANGE_METRIC_COSINE: cosine distance
+ *
+ * Distance used to compare coefficients with the last posted ones.
+ */
+typedef enum
+{
+  GST_CEPSTRUM_CHANGE_METRIC_L2,
+  GST_CEPSTRUM_CHANGE_METRIC_COSINE
+} GstCepstrumChangeMetric;
+
+/**
+ * GstCepstrumDftMode:
+ * @GST_CEPSTRUM_DFT_MODE_AUTO: pick the cheaper of the two for the settings
+ * @GST_CEPSTRUM_DFT_MODE_FFT: an FFT of every frame
+ * @GST_CEPSTRUM_DFT_MODE_SLIDING: a sliding DFT of the filterbank bins
+ *
+ * How the spectrum of each frame is computed.
+ */
+typedef enum
+{
+  GST_CEPSTRUM_DFT_MODE_AUTO,
+  GST_CEPSTRUM_DFT_MODE_FFT,
+  GST_CEPSTRUM_DFT_MODE_SLIDING
+} GstCepstrumDftMode;
+
+/**
+ * GstCepstrumFeatureType:
+ * @GST_CEPSTRUM_FEATURE_TYPE_MFCC: Mel-frequency cepstral coefficients
+ * @GST_CEPSTRUM_FEATURE_TYPE_PNCC: power-normalized cepstral coefficients
+ *   of a gammatone filterbank
+ *
+ * Cepstral features computed from each frame.
+ */
+typedef enum
+{
+  GST_CEPSTRUM_FEATURE_TYPE_MFCC,
+  GST_CEPSTRUM_FEATURE_TYPE_PNCC
+} GstCepstrumFeatureType;
+
+/**
+ * GstCepstrumPreset:
+ * @GST_CEPSTRUM_PRESET_NONE: no preset, the properties as set
+ * @GST_CEPSTRUM_PRESET_HTK: HTK HCopy MFCC_0 defaults
+ * @GST_CEPSTRUM_PRESET_KALDI: Kaldi compute-mfcc-feats defaults
+ * @GST_CEPSTRUM_PRESET_LIBROSA: librosa.feature.mfcc defaults
+ *
+ * Feature extraction toolkit whose configuration is reproduced.
+ */
+typedef enum
+{
+  GST_CEPSTRUM_PRESET_NONE,
+  GST_CEPSTRUM_PRESET_HTK,
+  GST_CEPSTRUM_PRESET_KALDI,
+  GST_CEPSTRUM_PRESET_LIBROSA
+} GstCepstrumPreset;
+
+/**
+ * GstCepstrumWindow:
+ * @GST_CEPSTRUM_WINDOW_HAMMING: symmetric Hamming window
+ * @GST_CEPSTRUM_WINDOW_HANN: periodic Hann window
+ * @GST_CEPSTRUM_WINDOW_POVEY: symmetric Hann window to the power 0.85
+ * @GST_CEPSTRUM_WINDOW_RECTANGULAR: no window
+ *
+ * Window applied to each frame before the DFT.
+ */
+typedef enum
+{
+  GST_CEPSTRUM_WINDOW_HAMMING,
+  GST_CEPSTRUM_WINDOW_HANN,
+  GST_CEPSTRUM_WINDOW_POVEY,
+  GST_CEPSTRUM_WINDOW_RECTANGULAR
+} GstCepstrumWindow;
+
+/**
+ * GstCepstrumMelScale:
+ * @GST_CEPSTRUM_MEL_SCALE_HTK: 2595 log10 (1 + f / 700)
+ * @GST_CEPSTRUM_MEL_SCALE_SLANEY: linear below 1 kHz, logarithmic above
+ *
+ * Formula used to convert frequencies to Mel.
+ */
+typedef enum
+{
+  GST_CEPSTRUM_MEL_SCALE_HTK,
+  GST_CEPSTRUM_MEL_SCALE_SLANEY
+} GstCepstrumMelScale;
+
+/**
+ * GstCepstrumMelNorm:
+ * @GST_CEPSTRUM_MEL_NORM_NONE: filters peak at 1
+ * @GST_CEPSTRUM_MEL_NORM_SLANEY: filters have unit area in Hz
+ *
+ * Normalisation of the Mel filters.
+ */
+typedef enum
+{
+  GST_CEPSTRUM_MEL_NORM_NONE,
+  GST_CEPSTRUM_MEL_NORM_SLANEY
+} GstCepstrumMelNorm;
+
+/* dither, DC blocker and pre-emphasis, run on each sample as it enters the
+ * input ring unless a preset is set; the state carries over from one buffer
+ * to the next */
+struct _GstCepstrumPreFilter
+{
+  gfloat dither;                /* dither standard deviation, 0 to disable */
+  gfloat emphasis;              /* pre-emphasis coefficient, 0 to disable */
+  gfloat dc_pole;               /* DC blocker pole, 0 to disable */
+  gfloat x1;                    /* last input sample */
+  gfloat y1;                    /* last DC blocker output */
+  guint32 seed;                 /* state of the dither generator */
+};
 
 typedef void (*GstCepstrumInputData)(const guint8 * in, gfloat * out,
-    guint len, guint channels, gfloat max_value, guint op, guint nfft);
+    guint len, guint channels, gfloat max_value, guint op, guint nfft,
+    GstCepstrumPreFilter * filter);
 
+/* The per frame buffers (input_tmp, fftin, fftdata and frame_power) hold
+ * one frame for each of the num_slots frames analysed in a batch, spaced
+ * by the slot strides of the element. */
 struct _GstCepstrumChannel
 {
-  gfloat *input;
-  gfloat *input_tmp;
+  gfloat *input;                /* ring of pre-filtered samples */
+  GstCepstrumPreFilter prefilter;
+  gfloat *input_tmp;            /* windowed frames */
 #ifdef HAVE_LIBFFTW
+  gdouble *fftin;               /* input_tmp converted for FFTW */
   fftw_complex *fftdata;
+  fftw_complex *spectrum;       /* spectrum of the current frame */
   fftw_plan fftplan;
 #else
   GstFFTF32Complex *fftdata;
-  GstFFTF32 *fft_ctx;
+  GstFFTF32Complex *spectrum;   /* spectrum of the current frame */
+  GstFFTF32 **fft_ctx;          /* one per slot */
 #endif
   gfloat *spect_magnitude;
+  gfloat *frame_power;          /* power spectra of the batch */
+  gfloat *power;                /* power spectrum of the current frame */
+  GstCepstrumNoise *noise;      /* noise floor tracker */
+  GstCepstrumSdft *sdft;        /* sliding DFT, replaces the FFT if set */
+  GstCepstrumPncc *pncc;        /* PNCC smoothing state */
+  gfloat *mel;                  /* log Mel energies of the last frame, or
+                                 * its PNCC band values */
+  gfloat *band_sum;             /* PNCC band values summed over the
+                                 * interval */
+  gfloat *log_bands;            /* log gammatone energies of the last frame,
+                                 * PNCC mode only */
+  gfloat *cqt;                  /* constant-Q power summed over the
+                                 * interval */
+  gfloat *psd;                  /* raw power spectrum summed over the
+                                 * interval */
+  gfloat *magnitude;            /* magnitude spectrum, HTK preset only */
+  gfloat *frame_energy;         /* energy of the windowed frames of the
+                                 * batch, Kaldi preset only */
+  gdouble energy_sum;           /* frame energies summed over the
+                                 * interval */
   gfloat *mfcc;
+  gfloat *last_mfcc;            /* coefficients of the last posted message */
+};
+
+/* a filter of the Mel or gammatone filterbank, non-zero over the @len bins
+ * starting at @start */
+struct _GstCepstrumMelFilter
+{
+  guint start;
+  guint len;
+  gfloat *weights;
+};
+
+/* sparse spectral kernel of a constant-Q bin: the conjugate kernel
+ * spectrum over the @len FFT bins starting at @start, divided by the FFT
+ * length */
+struct _GstCepstrumCqtKernel
+{
+  guint start;
+  guint len;
+  gfloat *re;
+  gfloat *im;
+};
+
+/* an interval that ended before frame @after of the batch */
+struct _GstCepstrumInterval
+{
+  guint after;
+  GstClockTime timestamp;       /* start of the interval */
+  guint num_fft;                /* frames in the interval */
+};
+
+/* a range of batch slots analysed by one thread */
+struct _GstCepstrumJob
+{
+  GstCepstrum *cepstrum;
+  guint first;
+  guint last;
 };
 
 struct _GstCepstrum
@@ -66,21 +262,81 @@ struct _GstCepstrum
 
   /* properties */
   gint num_coeffs;              /* number of mfcc coefficients */
-  gint num_filters;             /* number of Mel filter banks */
+  guint mel_filters;            /* number of Mel filters, 0 for twice
+                                 * num_coeffs */
+  GstCepstrumPreset preset;     /* toolkit the settings come from */
+  GstCepstrumFeatureType feature_type;
 
   gint sample_rate;             /* sampling rate of the audio signal */
+  gdouble sample_scale;         /* input samples back to 16 bit values */
   gint fft_size;
   gint win_size;                /* hamming filter window size */
   gint hop_size;                /* hop size */
+  GstCepstrumDftMode dft_mode;  /* how frame spectra are computed */
+  gfloat low_freq;              /* lower edge of the filterbank (Hz) */
+  gfloat high_freq;             /* upper edge of the filterbank (Hz), 0 for
+                                 * the Nyquist frequency */
   gboolean use_preemphasis;     /* whether or not to use preemphasis filter */
   float preemphasis_coeff;      /* filter coefficient */
+  gboolean remove_dc;           /* whether or not to block DC */
+  gfloat dither;                /* dither in 16 bit sample units */
+  gboolean snip_edges;          /* only analyse complete windows */
+  GstCepstrumWindow window_type;
+  GstCepstrumMelScale mel_scale;
+  GstCepstrumMelNorm mel_norm;
+  gfloat energy_floor;          /* floor of the Mel energies before the log */
+  gfloat lifter;                /* cepstral lifter coefficient, 0 for none */
+  gboolean noise_reduction;     /* whether or not to subtract the noise floor */
+  gfloat noise_oversubtraction; /* noise floor scaling for subtraction */
 
   gboolean post_messages;       /* whether or not to post messages */
+  gboolean emit_signals;        /* whether or not to emit new-features */
   guint64 interval;             /* how many nanoseconds between emits */
   guint64 frames_per_interval;  /* how many frames per interval */
   guint64 frames_todo;
   gint threshold;               /* energy level threshold */
   gboolean multi_channel;       /* send separate channel results */
+  gfloat change_threshold;      /* minimum change to post a message */
+  GstCepstrumChangeMetric change_metric;
+  guint64 max_silence;          /* longest time without a message */
+
+  gchar *scorer_module;         /* path of the scoring module to load */
+  gchar *scorer_options;        /* option string passed to the scorer */
+  guint scorer_batch;           /* frames per scoring call */
+
+  gchar *gmm_model;             /* path of the GMM classifier to load */
+  guint gmm_smoothing;          /* decision smoothing time constant (frames) */
+
+  gchar *template_dir;          /* directory of DTW templates to load */
+  gfloat match_threshold;       /* maximum mean frame distance of a match */
+
+  gboolean fingerprint;         /* whether or not to compute fingerprints */
+
+  gboolean psd;                 /* whether or not to post the Welch PSD */
+  guint psd_decimation;         /* FFT bins averaged per PSD value */
+
+  guint cqt_bins;               /* constant-Q bins, 0 to disable */
+  guint cqt_bins_per_octave;
+  gfloat cqt_min_freq;          /* centre of the lowest constant-Q bin (Hz) */
+
+  gboolean onsets;              /* whether or not to detect onsets */
+  gfloat onset_threshold;       /* flux above the median for an onset */
+  guint onset_window;           /* frames in the median threshold */
+
+  gchar *lsh_index;             /* path of the LSH index to map */
+  guint lsh_num_results;        /* nearest entries reported per query */
+  gboolean lsh_per_frame;       /* query every frame instead of every interval */
+
+  gchar *tdoa_pairs;            /* channel pairs to estimate delays for */
+  guint64 tdoa_max_delay;       /* largest delay searched (nanoseconds) */
+
+  guint64 history_duration;     /* length of the frame history (nanoseconds) */
+
+  guint modulation_frames;      /* frames per modulation spectrum, 0 for none */
+  guint modulation_hop;         /* frames between modulation spectra */
+
+  guint analysis_threads;       /* threads computing frame spectra */
+  guint fft_threads;            /* FFTW threads for large transforms */
 
   guint64 num_frames;           /* frame count (1 sample per channel)
                                  * since last emit */
@@ -92,10 +348,127 @@ struct _GstCepstrum
   guint num_channels;
 
   guint input_pos;
+  guint win_len;                /* samples per frame, at most nfft */
+  guint hop_len;                /* samples between frames */
+  guint hop_pos;                /* samples since the last frame */
+  guint warmup;                 /* samples until the ring holds a window */
+  gboolean use_sdft;            /* spectra come from the sliding DFT */
+  gboolean idle;                /* no consumers, input is not analysed */
   guint64 error_per_interval;
   guint64 accumulated_error;
+  /* sample clock, the next input sample is at clock_ns + clock_rem / rate */
+  GstClockTime clock_ns;
+  guint64 clock_rem;
+  GstClockTime clock_start;     /* time of the first sample after a resync */
+  guint64 sample_ns;            /* GST_SECOND / rate */
+  guint64 sample_rem;           /* GST_SECOND % rate */
+  guint64 window_ns;            /* duration of win_len samples */
+  guint64 window_rem;
+  guint64 frame_index;          /* frames delivered since the last flush */
+  gboolean have_posted;         /* last_mfcc holds posted coefficients */
+  guint64 silence;              /* time since the last posted message */
+
+  gint num_filters;             /* number of Mel filter banks */
+  GstCepstrumMelFilter *filter_bank;
+  gfloat *window;               /* analysis window, win_len samples */
+  gfloat *dct;                  /* num_coeffs x num_filters DCT matrix,
+                                 * liftered */
+  guint bin_lo;                 /* first bin of the power spectrum computed,
+                                 * and index 0 of the power arrays */
+  guint bin_hi;                 /* bin after the last one computed */
 
-  gfloat **filter_bank;
+  guint num_psd;                /* PSD values per channel */
+  gdouble psd_norm;             /* sum of the squared window */
+
+  GstCepstrumCqtKernel *cqt_kernels;
+  guint num_cqt;                /* constant-Q bins below the Nyquist
+                                 * frequency */
+
+  guint frame_len;              /* floats per feature frame, all channels */
+  gfloat *features;             /* features of the last frame */
+  GArray *signal_features;      /* frames waiting for new-features */
+  GArray *signal_ts;            /* their timestamps */
+
+  GModule *scorer;
+  const GstCepstrumScorerInfo *scorer_info;
+  gpointer scorer_handle;
+  guint scorer_num_outputs;
+  gfloat *scorer_frames;        /* batch of frames waiting to be scored */
+  gfloat *scorer_scores;
+  guint scorer_pending;         /* frames in scorer_frames */
+  GstClockTime scorer_ts;       /* timestamp of the first pending frame */
+
+  GstCepstrumGmm *gmm;
+  gboolean gmm_active;          /* model matches the feature dimension */
+  gfloat *gmm_loglik;           /* per class log-likelihood of the frame */
+  gfloat *gmm_smoothed;         /* smoothed per class log-likelihood */
+  guint gmm_frames;             /* frames scored since the last flush */
+  guint gmm_class;              /* last posted decision */
+
+  GstCepstrumDtw *dtw;
+  gboolean dtw_active;          /* templates match the feature dimension */
+
+  GstCepstrumFingerprint *fp;
+
+  GstCepstrumOnset *onset;
+
+  GstCepstrumLsh *lsh;
+  gboolean lsh_active;          /* index matches the feature dimension */
+  GstCepstrumLshResult *lsh_results;
+
+  guint *tdoa_channels;         /* flattened list of channel pairs */
+  guint tdoa_num_pairs;
+  gfloat *tdoa_delays;          /* delay of each pair in the last frame */
+#ifdef HAVE_LIBFFTW
+  fftw_complex *tdoa_cross;     /* PHAT weighted cross power spectrum */
+  gdouble *tdoa_corr;           /* generalized cross correlation */
+  fftw_plan tdoa_plan;
+#else
+  GstFFTF32Complex *tdoa_cross;
+  gfloat *tdoa_corr;
+  GstFFTF32 *tdoa_ctx;
+#endif
+
+  guint mod_len;                /* frames per modulation spectrum, even */
+  guint mod_bins;               /* modulation frequencies per band */
+  guint mod_pos;                /* envelope slot written next */
+  guint mod_count;              /* valid frames in the envelopes */
+  guint mod_todo;               /* frames until the next spectrum */
+  gfloat *mod_history;          /* ring of mod_len log Mel values per band */
+  gfloat *mod_window;
+  gfloat *mod_power;            /* modulation power, mod_bins per band */
+#ifdef HAVE_LIBFFTW
+  gdouble *mod_in;              /* windowed envelopes of all bands */
+  fftw_complex *mod_out;
+  fftw_plan mod_plan;           /* one plan transforming every band */
+#else
+  gfloat *mod_in;
+  GstFFTF32Complex *mod_out;
+  GstFFTF32 *mod_ctx;
+#endif
+
+  gfloat *history;              /* ring of the most recent feature frames */
+  GstClockTime *history_ts;     /* timestamps of the frames in history */
+  guint history_size;           /* capacity of the ring in frames */
+  guint history_pos;            /* slot the next frame is written to */
+  guint history_len;            /* valid frames in the ring */
+
+  guint num_slots;              /* frames analysed in one batch */
+  guint slot_stride;            /* input_tmp floats per slot */
+  guint fftin_stride;           /* fftin doubles per slot */
+  guint spectrum_stride;        /* fftdata bins per slot */
+  guint num_queued;             /* frames waiting in the batch */
+  GstClockTime *slot_ts;        /* timestamps of the queued frames */
+  gboolean *slot_on_hop;        /* whether each queued frame is on the hop
+                                 * grid */
+  GstCepstrumInterval *intervals; /* intervals ending within the batch */
+  guint num_intervals;
+  guint num_threads;            /* threads used for a batch */
+  GThreadPool *pool;
+  GstCepstrumJob *jobs;
+  guint jobs_pending;
+  GMutex jobs_lock;
+  GCond jobs_cond;
 
   GMutex lock;
 
@@ -105,6 +478,9 @@ struct _GstCepstrum
 struct _GstCepstrumClass
 {
   GstAudioFilterClass parent_class;
+
+  /* actions */
+  GstBuffer * (*get_history) (GstCepstrum * cepstrum, guint64 duration);
 };
 
 GType gst_cepstrum_get_type (void);
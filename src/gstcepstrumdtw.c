@@ -0,0 +1,470 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <math.h>
+#include "gstcepstrumdtw.h"
+
+#define DTW_MAGIC           "CDTW"
+#define DTW_VERSION         1
+#define DTW_SUFFIX          ".dtw"
+#define DTW_MAX_DIM         4096
+#define DTW_MAX_FRAMES      65536
+#define DTW_INF             G_MAXFLOAT
+#define DTW_BEAM            3.0f        /* running mean distance over the
+                                         * threshold a path may reach */
+
+/* number of floats processed per vector operation, frames are zero padded
+ * to a multiple of this */
+#define DTW_LANES           8
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DTW_USE_VECTOR 1
+typedef gfloat dtw_vec __attribute__ ((vector_size (DTW_LANES * sizeof (gfloat))));
+#endif
+
+typedef struct
+{
+  gchar *name;
+  guint num_frames;
+  gfloat *frames;               /* num_frames x dim_pad */
+
+  gfloat *acc[2];               /* accumulated cost, last and new column,
+                                 * DTW_INF outside the live cells */
+  guint64 *start[2];            /* input frame index a path starts at */
+  guint64 *start_ts[2];         /* timestamp a path starts at */
+  guint *live[2];               /* finite cells of the columns, ascending */
+  guint num_live[2];
+  guint cur;
+
+  /* best match seen so far while the distance keeps dropping */
+  gboolean have_best;
+  GstCepstrumDtwMatch best;
+} DtwTemplate;
+
+struct _GstCepstrumDtw
+{
+  guint dim;
+  guint dim_pad;
+  GPtrArray *templates;
+  guint64 frame_index;
+  gfloat *x;                    /* padded copy of the input frame */
+  GArray *matches;
+};
+
+static void
+dtw_template_free (gpointer data)
+{
+  DtwTemplate *t = data;
+  guint i;
+
+  g_free (t->name);
+  g_free (t->frames);
+  for (i = 0; i < 2; i++) {
+    g_free (t->acc[i]);
+    g_free (t->live[i]);
+    g_free (t->start[i]);
+    g_free (t->start_ts[i]);
+  }
+  g_free (t);
+}
+
+static void
+dtw_template_reset (DtwTemplate * t)
+{
+  guint i, j;
+
+  for (i = 0; i < 2; i++) {
+    for (j = 0; j < t->num_frames; j++)
+      t->acc[i][j] = DTW_INF;
+    t->num_live[i] = 0;
+  }
+  t->have_best = FALSE;
+}
+
+GstCepstrumDtw *
+gst_cepstrum_dtw_new (void)
+{
+  GstCepstrumDtw *dtw = g_new0 (GstCepstrumDtw, 1);
+
+  dtw->templates = g_ptr_array_new_with_free_func (dtw_template_free);
+  dtw->matches = g_array_new (FALSE, FALSE, sizeof (GstCepstrumDtwMatch));
+
+  return dtw;
+}
+
+void
+gst_cepstrum_dtw_free (GstCepstrumDtw * dtw)
+{
+  if (dtw == NULL)
+    return;
+
+  g_ptr_array_unref (dtw->templates);
+  g_array_free (dtw->matches, TRUE);
+  g_free (dtw->x);
+  g_free (dtw);
+}
+
+static guint32
+dtw_read_u32 (const guint8 * data)
+{
+  guint32 le;
+
+  memcpy (&le, data, 4);
+  return GUINT32_FROM_LE (le);
+}
+
+gboolean
+gst_cepstrum_dtw_add_template (GstCepstrumDtw * dtw, const gchar * filename,
+    GError ** error)
+{
+  DtwTemplate *t;
+  const guint8 *data;
+  gchar *contents, *basename, *dot;
+  gsize length;
+  guint32 version, dim, num_frames;
+  guint i, j;
+
+  if (!g_file_get_contents (filename, &contents, &length, error))
+    return FALSE;
+  data = (const guint8 *) contents;
+
+  if (length < 16 || memcmp (data, DTW_MAGIC, 4) != 0) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "%s: not a template file", filename);
+    goto error;
+  }
+
+  version = dtw_read_u32 (data + 4);
+  dim = dtw_read_u32 (data + 8);
+  num_frames = dtw_read_u32 (data + 12);
+  if (version != DTW_VERSION || dim == 0 || dim > DTW_MAX_DIM ||
+      num_frames == 0 || num_frames > DTW_MAX_FRAMES ||
+      (dtw->dim != 0 && dim != dtw->dim)) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "%s: unsupported template (version %u, dim %u, frames %u)",
+        filename, version, dim, num_frames);
+    goto error;
+  }
+  if ((length - 16) / sizeof (gfloat) / dim < num_frames) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "%s: truncated template file", filename);
+    goto error;
+  }
+
+  if (dtw->dim == 0) {
+    dtw->dim = dim;
+    dtw->dim_pad = (dim + DTW_LANES - 1) / DTW_LANES * DTW_LANES;
+    dtw->x = g_new0 (gfloat, dtw->dim_pad);
+  }
+
+  t = g_new0 (DtwTemplate, 1);
+  basename = g_path_get_basename (filename);
+  if ((dot = strrchr (basename, '.')) != NULL && dot != basename)
+    *dot = '\0';
+  t->name = basename;
+  t->num_frames = num_frames;
+  t->frames = g_new0 (gfloat, num_frames * dtw->dim_pad);
+  for (i = 0; i < num_frames; i++) {
+    for (j = 0; j < dim; j++) {
+      union
+      {
+        guint32 i;
+        gfloat f;
+      } u;
+
+      u.i = dtw_read_u32 (data + 16 + (i * dim + j) * sizeof (gfloat));
+      t->frames[i * dtw->dim_pad + j] = u.f;
+    }
+  }
+  for (i = 0; i < 2; i++) {
+    t->acc[i] = g_new (gfloat, num_frames);
+    t->live[i] = g_new (guint, num_frames);
+    t->start[i] = g_new0 (guint64, num_frames);
+    t->start_ts[i] = g_new0 (guint64, num_frames);
+  }
+  dtw_template_reset (t);
+
+  g_ptr_array_add (dtw->templates, t);
+  g_free (contents);
+
+  return TRUE;
+
+error:
+  g_free (contents);
+  return FALSE;
+}
+
+/* load all DTW_SUFFIX files of @dirname, returns the number of templates
+ * loaded. Invalid files are skipped, the first failure is kept in @error */
+guint
+gst_cepstrum_dtw_add_template_dir (GstCepstrumDtw * dtw,
+    const gchar * dirname, GError ** error)
+{
+  const gchar *name;
+  GDir *dir;
+  guint num_loaded = 0;
+
+  dir = g_dir_open (dirname, 0, error);
+  if (dir == NULL)
+    return 0;
+
+  while ((name = g_dir_read_name (dir)) != NULL) {
+    gchar *filename;
+    GError *err = NULL;
+
+    if (!g_str_has_suffix (name, DTW_SUFFIX))
+      continue;
+
+    filename = g_build_filename (dirname, name, NULL);
+    if (gst_cepstrum_dtw_add_template (dtw, filename, &err))
+      num_loaded++;
+    else if (error != NULL && *error == NULL)
+      g_propagate_error (error, err);
+    else
+      g_clear_error (&err);
+    g_free (filename);
+  }
+  g_dir_close (dir);
+
+  return num_loaded;
+}
+
+guint
+gst_cepstrum_dtw_get_dim (const GstCepstrumDtw * dtw)
+{
+  return dtw->dim;
+}
+
+guint
+gst_cepstrum_dtw_get_num_templates (const GstCepstrumDtw * dtw)
+{
+  return dtw->templates->len;
+}
+
+void
+gst_cepstrum_dtw_reset (GstCepstrumDtw * dtw)
+{
+  guint i;
+
+  for (i = 0; i < dtw->templates->len; i++)
+    dtw_template_reset (g_ptr_array_index (dtw->templates, i));
+  dtw->frame_index = 0;
+}
+
+/* euclidean distance of x to a template frame */
+static inline gfloat
+dtw_cell_cost (const gfloat * x, const gfloat * f, guint dim_pad)
+{
+  gfloat sum = 0.0f;
+  guint i;
+
+#ifdef DTW_USE_VECTOR
+  dtw_vec acc = { 0 };
+
+  for (i = 0; i < dim_pad; i += DTW_LANES) {
+    dtw_vec vx, vf, diff;
+
+    memcpy (&vx, x + i, sizeof (dtw_vec));
+    memcpy (&vf, f + i, sizeof (dtw_vec));
+    diff = vx - vf;
+    acc += diff * diff;
+  }
+  for (i = 0; i < DTW_LANES; i++)
+    sum += acc[i];
+#else
+  for (i = 0; i < dim_pad; i++) {
+    gfloat diff = x[i] - f[i];
+    sum += diff * diff;
+  }
+#endif
+
+  return sqrtf (sum);
+}
+
+/* advance the accumulated cost column of @t by one input frame @x.
+ *
+ * Only the band of cells reachable from the live cells of the last column
+ * is visited, a path advances 0, 1 or 2 template frames per input frame.
+ * A path leaves the band when it took more than twice as many input frames
+ * as template frames, when its mean distance so far is over DTW_BEAM times
+ * @threshold, or when its cost is too high for any path of at most twice
+ * the template length to end under @threshold. The work per frame follows
+ * the number of live paths, not the template length. */
+static void
+dtw_template_update (DtwTemplate * t, const gfloat * x, guint dim_pad,
+    guint64 index, guint64 timestamp, gfloat threshold)
+{
+  guint last = t->cur, next = t->cur ^ 1;
+  gfloat *acc = t->acc[last];
+  const guint64 *start = t->start[last];
+  const guint64 *start_ts = t->start_ts[last];
+  const guint *live = t->live[last];
+  guint num_live = t->num_live[last];
+  gfloat *nacc = t->acc[next];
+  guint64 *nstart = t->start[next];
+  guint64 *nstart_ts = t->start_ts[next];
+  guint *nlive = t->live[next];
+  guint num_nlive = 0;
+  gfloat max_acc = threshold * 2 * t->num_frames;
+  gfloat beam = DTW_BEAM * threshold;
+  guint l = 0, j = 0, end = 0;
+
+  /* cell 0, where a path may start at every input frame, then the cells
+   * up to 2 after each live one, in ascending order */
+  for (;;) {
+    gfloat best, sum;
+    guint from;
+    guint64 len;
+
+    if (j >= end) {
+      if (j > 0 && l == num_live)
+        break;
+      if (j > 0) {
+        j = MAX (j, live[l]);
+        end = MIN (t->num_frames, live[l] + 3);
+        l++;
+      } else {
+        end = 1;
+      }
+      if (j >= end)
+        continue;
+    }
+
+    if (j == 0) {
+      best = 0.0f;
+      from = 0;
+      len = 1;
+    } else {
+      best = acc[j];
+      from = j;
+      if (acc[j - 1] < best) {
+        best = acc[j - 1];
+        from = j - 1;
+      }
+      if (j >= 2 && acc[j - 2] < best) {
+        best = acc[j - 2];
+        from = j - 2;
+      }
+      if (best >= DTW_INF) {
+        j++;
+        continue;
+      }
+      len = index - start[from] + 1;
+      if (len > 2 * (j + 1)) {
+        j++;
+        continue;
+      }
+    }
+
+    sum = best + dtw_cell_cost (x, t->frames + j * dim_pad, dim_pad);
+    if (sum <= max_acc && sum <= beam * len) {
+      nacc[j] = sum;
+      if (j == 0) {
+        nstart[j] = index;
+        nstart_ts[j] = timestamp;
+      } else {
+        nstart[j] = start[from];
+        nstart_ts[j] = start_ts[from];
+      }
+      nlive[num_nlive++] = j;
+    }
+    j++;
+  }
+
+  /* the last column becomes the next one to fill, it must be all DTW_INF */
+  for (l = 0; l < num_live; l++)
+    acc[live[l]] = DTW_INF;
+
+  t->num_live[next] = num_nlive;
+  t->cur = next;
+}
+
+/* feed one frame to all templates. Returns the number of matches found,
+ * which are valid until the next call */
+guint
+gst_cepstrum_dtw_push (GstCepstrumDtw * dtw, const gfloat * frame,
+    guint64 timestamp, gfloat threshold,
+    const GstCepstrumDtwMatch ** matches)
+{
+  guint64 index = dtw->frame_index++;
+  guint i;
+
+  g_array_set_size (dtw->matches, 0);
+  memcpy (dtw->x, frame, dtw->dim * sizeof (gfloat));
+
+  for (i = 0; i < dtw->templates->len; i++) {
+    DtwTemplate *t = g_ptr_array_index (dtw->templates, i);
+    guint end = t->num_frames - 1;
+    gfloat distance = DTW_INF;
+    guint num_frames = 0;
+
+    dtw_template_update (t, dtw->x, dtw->dim_pad, index, timestamp,
+        threshold);
+
+    if (t->acc[t->cur][end] < DTW_INF) {
+      num_frames = index - t->start[t->cur][end] + 1;
+      distance = t->acc[t->cur][end] / num_frames;
+    }
+
+    /* keep following the match while it improves, report it at its
+     * minimum and restart so matches do not overlap */
+    if (distance < threshold &&
+        (!t->have_best || distance <= t->best.distance)) {
+      t->have_best = TRUE;
+      t->best.name = t->name;
+      t->best.start_ts = t->start_ts[t->cur][end];
+      t->best.end_ts = timestamp;
+      t->best.num_frames = num_frames;
+      t->best.distance = distance;
+    } else if (t->have_best) {
+      g_array_append_val (dtw->matches, t->best);
+      dtw_template_reset (t);
+    }
+  }
+
+  *matches = (const GstCepstrumDtwMatch *) dtw->matches->data;
+  return dtw->matches->len;
+}
+
+/* end of the stream: report the matches that were still improving with the
+ * last frame and reset. The matches are valid until the next call */
+guint
+gst_cepstrum_dtw_finish (GstCepstrumDtw * dtw,
+    const GstCepstrumDtwMatch ** matches)
+{
+  guint i;
+
+  g_array_set_size (dtw->matches, 0);
+
+  for (i = 0; i < dtw->templates->len; i++) {
+    DtwTemplate *t = g_ptr_array_index (dtw->templates, i);
+
+    if (t->have_best)
+      g_array_append_val (dtw->matches, t->best);
+  }
+  gst_cepstrum_dtw_reset (dtw);
+
+  *matches = (const GstCepstrumDtwMatch *) dtw->matches->data;
+  return dtw->matches->len;
+}
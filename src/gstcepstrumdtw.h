@@ -0,0 +1,79 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_CEPSTRUM_DTW_H__
+#define __GST_CEPSTRUM_DTW_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Streaming subsequence DTW matcher over feature frames.
+ *
+ * Template files are little endian and laid out as:
+ *
+ *   char    magic[4]          "CDTW"
+ *   guint32 version           1
+ *   guint32 dim               feature dimension
+ *   guint32 num_frames
+ *   gfloat  frames[num_frames][dim]
+ *
+ * A template may start at any input frame. Each input frame advances the
+ * template by 0, 1 or 2 frames and a match may span at most twice the
+ * template length. Only the cells of paths still within that band are
+ * updated for each frame: a path is dropped once its mean frame distance is
+ * more than three times the match threshold. A match still improving at
+ * the end of the stream is reported by gst_cepstrum_dtw_finish().
+ */
+
+typedef struct _GstCepstrumDtw GstCepstrumDtw;
+typedef struct _GstCepstrumDtwMatch GstCepstrumDtwMatch;
+
+struct _GstCepstrumDtwMatch
+{
+  const gchar *name;            /* template name, owned by the matcher */
+  guint64 start_ts;             /* timestamp of the first matched frame */
+  guint64 end_ts;               /* timestamp of the last matched frame */
+  guint num_frames;             /* number of input frames matched */
+  gfloat distance;              /* mean frame distance along the path */
+};
+
+GstCepstrumDtw * gst_cepstrum_dtw_new (void);
+void gst_cepstrum_dtw_free (GstCepstrumDtw * dtw);
+
+gboolean gst_cepstrum_dtw_add_template (GstCepstrumDtw * dtw,
+    const gchar * filename, GError ** error);
+guint gst_cepstrum_dtw_add_template_dir (GstCepstrumDtw * dtw,
+    const gchar * dirname, GError ** error);
+
+guint gst_cepstrum_dtw_get_dim (const GstCepstrumDtw * dtw);
+guint gst_cepstrum_dtw_get_num_templates (const GstCepstrumDtw * dtw);
+
+void gst_cepstrum_dtw_reset (GstCepstrumDtw * dtw);
+
+guint gst_cepstrum_dtw_push (GstCepstrumDtw * dtw, const gfloat * frame,
+    guint64 timestamp, gfloat threshold,
+    const GstCepstrumDtwMatch ** matches);
+guint gst_cepstrum_dtw_finish (GstCepstrumDtw * dtw,
+    const GstCepstrumDtwMatch ** matches);
+
+G_END_DECLS
+
+#endif /* __GST_CEPSTRUM_DTW_H__ */
@@ -0,0 +1,180 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "gstcepstrumfingerprint.h"
+
+#define FP_MAX_PEAKS        5   /* peaks kept per frame */
+#define FP_NEIGHBOURHOOD    3   /* bins on each side a peak must dominate */
+#define FP_PEAK_RATIO       4.0f        /* minimum peak to frame mean ratio */
+#define FP_ZONE_FRAMES      32  /* target zone length in frames */
+#define FP_ZONE_BINS        64  /* target zone half height, quantised bins */
+#define FP_FAN_OUT          10  /* maximum pairs per anchor */
+#define FP_FREQ_BITS        10
+#define FP_DT_BITS          12
+
+typedef struct
+{
+  guint num_peaks;
+  guint bins[FP_MAX_PEAKS];     /* quantised peak frequencies */
+  guint64 timestamp;
+} FpFrame;
+
+struct _GstCepstrumFingerprint
+{
+  guint num_bins;
+  FpFrame frames[FP_ZONE_FRAMES + 1];   /* ring of the last frames' peaks */
+  guint64 num_frames;           /* frames pushed since the last reset */
+  gfloat peak_power[FP_MAX_PEAKS];
+  GArray *landmarks;
+};
+
+GstCepstrumFingerprint *
+gst_cepstrum_fingerprint_new (guint num_bins)
+{
+  GstCepstrumFingerprint *fp = g_new0 (GstCepstrumFingerprint, 1);
+
+  fp->num_bins = num_bins;
+  fp->landmarks = g_array_new (FALSE, FALSE, sizeof (GstCepstrumLandmark));
+
+  return fp;
+}
+
+void
+gst_cepstrum_fingerprint_free (GstCepstrumFingerprint * fp)
+{
+  if (fp == NULL)
+    return;
+
+  g_array_free (fp->landmarks, TRUE);
+  g_free (fp);
+}
+
+void
+gst_cepstrum_fingerprint_reset (GstCepstrumFingerprint * fp)
+{
+  fp->num_frames = 0;
+  g_array_set_size (fp->landmarks, 0);
+}
+
+/* keep the FP_MAX_PEAKS strongest local maxima of @power */
+static void
+fp_pick_peaks (GstCepstrumFingerprint * fp, const gfloat * power,
+    FpFrame * frame)
+{
+  guint num_bins = fp->num_bins;
+  gfloat *peak_power = fp->peak_power;
+  gfloat mean = 0.0f;
+  guint k, i, n = 0;
+
+  for (k = 0; k < num_bins; k++)
+    mean += power[k];
+  mean /= num_bins;
+
+  for (k = FP_NEIGHBOURHOOD; k + FP_NEIGHBOURHOOD < num_bins; k++) {
+    gfloat p = power[k];
+
+    if (p <= FP_PEAK_RATIO * mean)
+      continue;
+    for (i = 1; i <= FP_NEIGHBOURHOOD; i++) {
+      if (power[k - i] >= p || power[k + i] > p)
+        break;
+    }
+    if (i <= FP_NEIGHBOURHOOD)
+      continue;
+
+    /* insertion into the list of strongest peaks */
+    if (n == FP_MAX_PEAKS && p <= peak_power[n - 1])
+      continue;
+    if (n < FP_MAX_PEAKS)
+      n++;
+    for (i = n - 1; i > 0 && peak_power[i - 1] < p; i--) {
+      peak_power[i] = peak_power[i - 1];
+      frame->bins[i] = frame->bins[i - 1];
+    }
+    peak_power[i] = p;
+    frame->bins[i] = (guint) ((guint64) k * (1 << FP_FREQ_BITS) / num_bins);
+  }
+  frame->num_peaks = n;
+}
+
+/* pair the peaks of the anchor frame with those of the FP_ZONE_FRAMES
+ * frames that followed it */
+static void
+fp_hash_anchor (GstCepstrumFingerprint * fp, guint64 anchor)
+{
+  const FpFrame *a = &fp->frames[anchor % (FP_ZONE_FRAMES + 1)];
+  guint p, q, dt;
+
+  for (p = 0; p < a->num_peaks; p++) {
+    guint f1 = a->bins[p];
+    guint pairs = 0;
+
+    for (dt = 1; dt <= FP_ZONE_FRAMES && pairs < FP_FAN_OUT; dt++) {
+      const FpFrame *t = &fp->frames[(anchor + dt) % (FP_ZONE_FRAMES + 1)];
+
+      for (q = 0; q < t->num_peaks && pairs < FP_FAN_OUT; q++) {
+        guint f2 = t->bins[q];
+        GstCepstrumLandmark lm;
+
+        if (ABS ((gint) f2 - (gint) f1) > FP_ZONE_BINS)
+          continue;
+
+        lm.hash = (f1 << (FP_FREQ_BITS + FP_DT_BITS)) |
+            (f2 << FP_DT_BITS) | dt;
+        lm.timestamp = a->timestamp;
+        g_array_append_val (fp->landmarks, lm);
+        pairs++;
+      }
+    }
+  }
+}
+
+void
+gst_cepstrum_fingerprint_push (GstCepstrumFingerprint * fp,
+    const gfloat * power, guint64 timestamp)
+{
+  FpFrame *frame = &fp->frames[fp->num_frames % (FP_ZONE_FRAMES + 1)];
+
+  fp_pick_peaks (fp, power, frame);
+  frame->timestamp = timestamp;
+
+  /* the target zone of the frame FP_ZONE_FRAMES back is now complete */
+  if (fp->num_frames >= FP_ZONE_FRAMES)
+    fp_hash_anchor (fp, fp->num_frames - FP_ZONE_FRAMES);
+  fp->num_frames++;
+}
+
+const GstCepstrumLandmark *
+gst_cepstrum_fingerprint_get_landmarks (GstCepstrumFingerprint * fp,
+    guint * num_landmarks)
+{
+  *num_landmarks = fp->landmarks->len;
+  return (const GstCepstrumLandmark *) fp->landmarks->data;
+}
+
+void
+gst_cepstrum_fingerprint_clear_landmarks (GstCepstrumFingerprint * fp)
+{
+  g_array_set_size (fp->landmarks, 0);
+}
@@ -0,0 +1,58 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_CEPSTRUM_FINGERPRINT_H__
+#define __GST_CEPSTRUM_FINGERPRINT_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Landmark fingerprinter working on power spectrum frames.
+ *
+ * Spectral peaks are picked in every frame and each peak (the anchor) is
+ * paired with the peaks of the following frames within a target zone. The
+ * resulting hash packs the quantised anchor frequency (10 bits), the
+ * quantised target frequency (10 bits) and the frame distance (12 bits).
+ */
+
+typedef struct _GstCepstrumFingerprint GstCepstrumFingerprint;
+typedef struct _GstCepstrumLandmark GstCepstrumLandmark;
+
+struct _GstCepstrumLandmark
+{
+  guint32 hash;
+  guint64 timestamp;            /* timestamp of the anchor frame */
+};
+
+GstCepstrumFingerprint * gst_cepstrum_fingerprint_new (guint num_bins);
+void gst_cepstrum_fingerprint_free (GstCepstrumFingerprint * fp);
+void gst_cepstrum_fingerprint_reset (GstCepstrumFingerprint * fp);
+
+void gst_cepstrum_fingerprint_push (GstCepstrumFingerprint * fp,
+    const gfloat * power, guint64 timestamp);
+
+const GstCepstrumLandmark * gst_cepstrum_fingerprint_get_landmarks (
+    GstCepstrumFingerprint * fp, guint * num_landmarks);
+void gst_cepstrum_fingerprint_clear_landmarks (GstCepstrumFingerprint * fp);
+
+G_END_DECLS
+
+#endif /* __GST_CEPSTRUM_FINGERPRINT_H__ */
@@ -0,0 +1,309 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <math.h>
+#include "gstcepstrumgmm.h"
+
+#define GMM_MAGIC           "CGMM"
+#define GMM_VERSION         1
+#define GMM_MAX_DIM         4096
+#define GMM_MAX_CLASSES     256
+#define GMM_MAX_COMPONENTS  65536
+#define GMM_VARIANCE_FLOOR  1e-10f
+
+/* number of floats processed per vector operation, feature vectors are
+ * zero padded to a multiple of this */
+#define GMM_LANES           8
+
+#if defined(__GNUC__) || defined(__clang__)
+#define GMM_USE_VECTOR 1
+typedef gfloat gmm_vec __attribute__ ((vector_size (GMM_LANES * sizeof (gfloat))));
+#endif
+
+struct _GstCepstrumGmm
+{
+  guint dim;
+  guint dim_pad;                /* dim rounded up to GMM_LANES */
+  guint num_classes;
+  guint *num_components;        /* components of each class */
+  guint *first_component;       /* index of the first component of a class */
+  guint max_components;
+
+  gfloat *means;                /* components x dim_pad */
+  gfloat *precisions;           /* inverse variances, 0 in the padding */
+  gfloat *gconsts;              /* log weight - log normaliser */
+
+  gfloat *x;                    /* padded copy of the frame being scored */
+  gfloat *loglik;               /* per component scratch */
+};
+
+typedef struct
+{
+  const guint8 *pos;
+  const guint8 *end;
+} GmmReader;
+
+static gboolean
+gmm_read_u32 (GmmReader * r, guint32 * v)
+{
+  guint32 le;
+
+  if (r->end - r->pos < 4)
+    return FALSE;
+  memcpy (&le, r->pos, 4);
+  *v = GUINT32_FROM_LE (le);
+  r->pos += 4;
+  return TRUE;
+}
+
+static gboolean
+gmm_read_float (GmmReader * r, gfloat * v)
+{
+  union
+  {
+    guint32 i;
+    gfloat f;
+  } u;
+
+  if (!gmm_read_u32 (r, &u.i))
+    return FALSE;
+  *v = u.f;
+  return TRUE;
+}
+
+static gboolean
+gmm_parse (GstCepstrumGmm * gmm, GmmReader * r, GError ** error)
+{
+  GArray *means, *precisions, *gconsts;
+  guint32 version, dim, num_classes, num_components;
+  guint c, k, d, first = 0;
+
+  if (r->end - r->pos < 4 || memcmp (r->pos, GMM_MAGIC, 4) != 0) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "not a GMM file");
+    return FALSE;
+  }
+  r->pos += 4;
+
+  if (!gmm_read_u32 (r, &version) || !gmm_read_u32 (r, &dim) ||
+      !gmm_read_u32 (r, &num_classes)) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "truncated GMM file");
+    return FALSE;
+  }
+
+  if (version != GMM_VERSION || dim == 0 || dim > GMM_MAX_DIM ||
+      num_classes == 0 || num_classes > GMM_MAX_CLASSES) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "unsupported GMM header (version %u, dim %u, classes %u)", version,
+        dim, num_classes);
+    return FALSE;
+  }
+
+  gmm->dim = dim;
+  gmm->dim_pad = (dim + GMM_LANES - 1) / GMM_LANES * GMM_LANES;
+  gmm->num_classes = num_classes;
+  gmm->num_components = g_new0 (guint, num_classes);
+  gmm->first_component = g_new0 (guint, num_classes);
+
+  means = g_array_new (FALSE, TRUE, sizeof (gfloat));
+  precisions = g_array_new (FALSE, TRUE, sizeof (gfloat));
+  gconsts = g_array_new (FALSE, TRUE, sizeof (gfloat));
+
+  for (c = 0; c < num_classes; c++) {
+    if (!gmm_read_u32 (r, &num_components))
+      goto truncated;
+    if (num_components == 0 || num_components > GMM_MAX_COMPONENTS) {
+      g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+          "class %u has %u components", c, num_components);
+      goto error;
+    }
+
+    gmm->num_components[c] = num_components;
+    gmm->first_component[c] = first;
+    gmm->max_components = MAX (gmm->max_components, num_components);
+    first += num_components;
+
+    g_array_set_size (means, first * gmm->dim_pad);
+    g_array_set_size (precisions, first * gmm->dim_pad);
+
+    for (k = first - num_components; k < first; k++) {
+      gfloat *mean = &g_array_index (means, gfloat, k * gmm->dim_pad);
+      gfloat *prec = &g_array_index (precisions, gfloat, k * gmm->dim_pad);
+      gdouble gconst;
+      gfloat weight, var, value;
+
+      if (!gmm_read_float (r, &weight))
+        goto truncated;
+      gconst = log (MAX (weight, G_MINFLOAT)) - 0.5 * dim * log (2 * G_PI);
+
+      for (d = 0; d < dim; d++) {
+        if (!gmm_read_float (r, &mean[d]))
+          goto truncated;
+      }
+      for (d = 0; d < dim; d++) {
+        if (!gmm_read_float (r, &var))
+          goto truncated;
+        var = MAX (var, GMM_VARIANCE_FLOOR);
+        prec[d] = 1.0f / var;
+        gconst -= 0.5 * log (var);
+      }
+
+      value = gconst;
+      g_array_append_val (gconsts, value);
+    }
+  }
+
+  gmm->means = (gfloat *) g_array_free (means, FALSE);
+  gmm->precisions = (gfloat *) g_array_free (precisions, FALSE);
+  gmm->gconsts = (gfloat *) g_array_free (gconsts, FALSE);
+  gmm->x = g_new0 (gfloat, gmm->dim_pad);
+  gmm->loglik = g_new0 (gfloat, gmm->max_components);
+
+  return TRUE;
+
+truncated:
+  g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "truncated GMM file");
+error:
+  g_array_free (means, TRUE);
+  g_array_free (precisions, TRUE);
+  g_array_free (gconsts, TRUE);
+  return FALSE;
+}
+
+GstCepstrumGmm *
+gst_cepstrum_gmm_load (const gchar * filename, GError ** error)
+{
+  GstCepstrumGmm *gmm;
+  GmmReader r;
+  gchar *contents;
+  gsize length;
+
+  if (!g_file_get_contents (filename, &contents, &length, error))
+    return NULL;
+
+  gmm = g_new0 (GstCepstrumGmm, 1);
+  r.pos = (const guint8 *) contents;
+  r.end = r.pos + length;
+
+  if (!gmm_parse (gmm, &r, error)) {
+    gst_cepstrum_gmm_free (gmm);
+    gmm = NULL;
+  }
+  g_free (contents);
+
+  return gmm;
+}
+
+void
+gst_cepstrum_gmm_free (GstCepstrumGmm * gmm)
+{
+  if (gmm == NULL)
+    return;
+
+  g_free (gmm->num_components);
+  g_free (gmm->first_component);
+  g_free (gmm->means);
+  g_free (gmm->precisions);
+  g_free (gmm->gconsts);
+  g_free (gmm->x);
+  g_free (gmm->loglik);
+  g_free (gmm);
+}
+
+guint
+gst_cepstrum_gmm_get_dim (const GstCepstrumGmm * gmm)
+{
+  return gmm->dim;
+}
+
+guint
+gst_cepstrum_gmm_get_num_classes (const GstCepstrumGmm * gmm)
+{
+  return gmm->num_classes;
+}
+
+/* precision weighted squared distance of x to one component mean */
+static inline gfloat
+gmm_distance (const gfloat * x, const gfloat * mean, const gfloat * prec,
+    guint dim_pad)
+{
+  gfloat sum = 0.0f;
+  guint i;
+
+#ifdef GMM_USE_VECTOR
+  gmm_vec acc = { 0 };
+
+  for (i = 0; i < dim_pad; i += GMM_LANES) {
+    gmm_vec vx, vm, vp, diff;
+
+    memcpy (&vx, x + i, sizeof (gmm_vec));
+    memcpy (&vm, mean + i, sizeof (gmm_vec));
+    memcpy (&vp, prec + i, sizeof (gmm_vec));
+    diff = vx - vm;
+    acc += diff * diff * vp;
+  }
+  for (i = 0; i < GMM_LANES; i++)
+    sum += acc[i];
+#else
+  for (i = 0; i < dim_pad; i++) {
+    gfloat diff = x[i] - mean[i];
+    sum += diff * diff * prec[i];
+  }
+#endif
+
+  return sum;
+}
+
+/* write the log-likelihood of @features under each class to @loglik */
+void
+gst_cepstrum_gmm_score (GstCepstrumGmm * gmm, const gfloat * features,
+    gfloat * loglik)
+{
+  guint dim_pad = gmm->dim_pad;
+  guint c, k;
+
+  memcpy (gmm->x, features, gmm->dim * sizeof (gfloat));
+
+  for (c = 0; c < gmm->num_classes; c++) {
+    guint first = gmm->first_component[c];
+    guint num_components = gmm->num_components[c];
+    gfloat max = -G_MAXFLOAT;
+    gdouble sum = 0.0;
+
+    for (k = 0; k < num_components; k++) {
+      guint idx = first + k;
+      gfloat ll = gmm->gconsts[idx] - 0.5f * gmm_distance (gmm->x,
+          gmm->means + idx * dim_pad, gmm->precisions + idx * dim_pad,
+          dim_pad);
+
+      gmm->loglik[k] = ll;
+      max = MAX (max, ll);
+    }
+
+    /* log-sum-exp over the mixture */
+    for (k = 0; k < num_components; k++)
+      sum += exp (gmm->loglik[k] - max);
+    loglik[c] = max + log (sum);
+  }
+}
@@ -0,0 +1,58 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_CEPSTRUM_GMM_H__
+#define __GST_CEPSTRUM_GMM_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Diagonal covariance GMM classifier.
+ *
+ * Model files are little endian and laid out as:
+ *
+ *   char    magic[4]          "CGMM"
+ *   guint32 version           1
+ *   guint32 dim               feature dimension
+ *   guint32 num_classes
+ *   for each class:
+ *     guint32 num_components
+ *     for each component:
+ *       gfloat weight
+ *       gfloat mean[dim]
+ *       gfloat variance[dim]
+ */
+
+typedef struct _GstCepstrumGmm GstCepstrumGmm;
+
+GstCepstrumGmm * gst_cepstrum_gmm_load (const gchar * filename,
+    GError ** error);
+void gst_cepstrum_gmm_free (GstCepstrumGmm * gmm);
+
+guint gst_cepstrum_gmm_get_dim (const GstCepstrumGmm * gmm);
+guint gst_cepstrum_gmm_get_num_classes (const GstCepstrumGmm * gmm);
+
+void gst_cepstrum_gmm_score (GstCepstrumGmm * gmm, const gfloat * features,
+    gfloat * loglik);
+
+G_END_DECLS
+
+#endif /* __GST_CEPSTRUM_GMM_H__ */
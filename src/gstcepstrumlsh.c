@@ -0,0 +1,246 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "gstcepstrumlsh.h"
+
+#define LSH_MAGIC           "CLSH"
+#define LSH_VERSION         1
+#define LSH_HEADER_SIZE     24
+#define LSH_MAX_DIM         4096
+#define LSH_MAX_BITS        1024
+
+#if defined(__GNUC__) || defined(__clang__)
+#define lsh_popcount64(x) __builtin_popcountll (x)
+#else
+static inline guint
+lsh_popcount64 (guint64 x)
+{
+  x = x - ((x >> 1) & G_GUINT64_CONSTANT (0x5555555555555555));
+  x = (x & G_GUINT64_CONSTANT (0x3333333333333333)) +
+      ((x >> 2) & G_GUINT64_CONSTANT (0x3333333333333333));
+  x = (x + (x >> 4)) & G_GUINT64_CONSTANT (0x0f0f0f0f0f0f0f0f);
+  return (x * G_GUINT64_CONSTANT (0x0101010101010101)) >> 56;
+}
+#endif
+
+struct _GstCepstrumLsh
+{
+  GMappedFile *file;
+
+  guint dim;
+  guint num_bits;
+  guint num_words;              /* 64 bit words per code */
+  guint64 num_entries;
+
+  /* pointers into the mapping */
+  const gfloat *projections;
+  const gfloat *thresholds;
+  const guint64 *codes;
+  const guint32 *ids;
+
+  guint64 *query;               /* code of the current query */
+};
+
+GstCepstrumLsh *
+gst_cepstrum_lsh_open (const gchar * filename, GError ** error)
+{
+  GstCepstrumLsh *lsh;
+  const guint8 *data;
+  guint32 version, dim, num_bits;
+  guint64 num_entries, offset, codes_size;
+  gsize length;
+
+#if G_BYTE_ORDER != G_LITTLE_ENDIAN
+  g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+      "LSH indexes can only be mapped on little endian hosts");
+  return NULL;
+#endif
+
+  lsh = g_new0 (GstCepstrumLsh, 1);
+  lsh->file = g_mapped_file_new (filename, FALSE, error);
+  if (lsh->file == NULL)
+    goto error;
+
+  data = (const guint8 *) g_mapped_file_get_contents (lsh->file);
+  length = g_mapped_file_get_length (lsh->file);
+
+  if (length < LSH_HEADER_SIZE || memcmp (data, LSH_MAGIC, 4) != 0) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "not an LSH index");
+    goto error;
+  }
+
+  memcpy (&version, data + 4, 4);
+  memcpy (&dim, data + 8, 4);
+  memcpy (&num_bits, data + 12, 4);
+  memcpy (&num_entries, data + 16, 8);
+
+  if (version != LSH_VERSION || dim == 0 || dim > LSH_MAX_DIM ||
+      num_bits == 0 || num_bits % 64 != 0 || num_bits > LSH_MAX_BITS) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "unsupported LSH index (version %u, dim %u, bits %u)", version, dim,
+        num_bits);
+    goto error;
+  }
+
+  lsh->dim = dim;
+  lsh->num_bits = num_bits;
+  lsh->num_words = num_bits / 64;
+  lsh->num_entries = num_entries;
+
+  offset = LSH_HEADER_SIZE;
+  lsh->projections = (const gfloat *) (data + offset);
+  offset += (guint64) num_bits * dim * sizeof (gfloat);
+  lsh->thresholds = (const gfloat *) (data + offset);
+  offset += (guint64) num_bits * sizeof (gfloat);
+  offset = (offset + 7) & ~G_GUINT64_CONSTANT (7);
+
+  if (offset > length || num_entries > (length - offset) /
+      (lsh->num_words * sizeof (guint64) + sizeof (guint32))) {
+    g_set_error (error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+        "truncated LSH index");
+    goto error;
+  }
+  codes_size = num_entries * lsh->num_words * sizeof (guint64);
+  lsh->codes = (const guint64 *) (data + offset);
+  lsh->ids = (const guint32 *) (data + offset + codes_size);
+
+  lsh->query = g_new0 (guint64, lsh->num_words);
+
+  return lsh;
+
+error:
+  gst_cepstrum_lsh_close (lsh);
+  return NULL;
+}
+
+void
+gst_cepstrum_lsh_close (GstCepstrumLsh * lsh)
+{
+  if (lsh == NULL)
+    return;
+
+  if (lsh->file)
+    g_mapped_file_unref (lsh->file);
+  g_free (lsh->query);
+  g_free (lsh);
+}
+
+guint
+gst_cepstrum_lsh_get_dim (const GstCepstrumLsh * lsh)
+{
+  return lsh->dim;
+}
+
+guint64
+gst_cepstrum_lsh_get_num_entries (const GstCepstrumLsh * lsh)
+{
+  return lsh->num_entries;
+}
+
+static void
+lsh_hash (GstCepstrumLsh * lsh, const gfloat * features)
+{
+  const gfloat *proj = lsh->projections;
+  guint b, d;
+
+  memset (lsh->query, 0, lsh->num_words * sizeof (guint64));
+
+  for (b = 0; b < lsh->num_bits; b++, proj += lsh->dim) {
+    gfloat dot = 0.0f;
+
+    for (d = 0; d < lsh->dim; d++)
+      dot += proj[d] * features[d];
+    if (dot > lsh->thresholds[b])
+      lsh->query[b / 64] |= G_GUINT64_CONSTANT (1) << (b % 64);
+  }
+}
+
+/* insert a candidate into the sorted result list, returns the new length */
+static inline guint
+lsh_insert (GstCepstrumLshResult * results, guint num_results,
+    guint max_results, guint32 id, guint distance)
+{
+  guint i;
+
+  if (num_results < max_results)
+    num_results++;
+  for (i = num_results - 1; i > 0 && results[i - 1].distance > distance; i--)
+    results[i] = results[i - 1];
+  results[i].id = id;
+  results[i].distance = distance;
+
+  return num_results;
+}
+
+/* exhaustive hamming scan of the index, writes up to @max_results nearest
+ * entries to @results sorted by distance and returns their number */
+guint
+gst_cepstrum_lsh_query (GstCepstrumLsh * lsh, const gfloat * features,
+    GstCepstrumLshResult * results, guint max_results)
+{
+  const guint64 *codes = lsh->codes;
+  const guint64 *query = lsh->query;
+  guint num_words = lsh->num_words;
+  guint num_results = 0;
+  guint worst = G_MAXUINT;
+  guint64 i;
+  guint w;
+
+  if (max_results == 0)
+    return 0;
+
+  lsh_hash (lsh, features);
+
+  if (num_words == 1) {
+    guint64 q = query[0];
+
+    for (i = 0; i < lsh->num_entries; i++) {
+      guint distance = lsh_popcount64 (codes[i] ^ q);
+
+      if (distance < worst) {
+        num_results = lsh_insert (results, num_results, max_results,
+            lsh->ids[i], distance);
+        if (num_results == max_results)
+          worst = results[num_results - 1].distance;
+      }
+    }
+  } else {
+    for (i = 0; i < lsh->num_entries; i++, codes += num_words) {
+      guint distance = 0;
+
+      for (w = 0; w < num_words; w++)
+        distance += lsh_popcount64 (codes[w] ^ query[w]);
+
+      if (distance < worst) {
+        num_results = lsh_insert (results, num_results, max_results,
+            lsh->ids[i], distance);
+        if (num_results == max_results)
+          worst = results[num_results - 1].distance;
+      }
+    }
+  }
+
+  return num_results;
+}
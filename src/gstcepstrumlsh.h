@@ -0,0 +1,68 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_CEPSTRUM_LSH_H__
+#define __GST_CEPSTRUM_LSH_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Random projection LSH index, memory-mapped from disk.
+ *
+ * Index files are little endian and laid out as:
+ *
+ *   char    magic[4]          "CLSH"
+ *   guint32 version           1
+ *   guint32 dim               feature dimension
+ *   guint32 num_bits          code length, a multiple of 64
+ *   guint64 num_entries
+ *   gfloat  projections[num_bits][dim]
+ *   gfloat  thresholds[num_bits]
+ *   padding to a multiple of 8 bytes
+ *   guint64 codes[num_entries][num_bits / 64]
+ *   guint32 ids[num_entries]
+ *
+ * Bit b of a code is set when the dot product of the feature vector with
+ * projection b is larger than threshold b.
+ */
+
+typedef struct _GstCepstrumLsh GstCepstrumLsh;
+typedef struct _GstCepstrumLshResult GstCepstrumLshResult;
+
+struct _GstCepstrumLshResult
+{
+  guint32 id;                   /* id of the reference entry */
+  guint distance;               /* hamming distance to the query */
+};
+
+GstCepstrumLsh * gst_cepstrum_lsh_open (const gchar * filename,
+    GError ** error);
+void gst_cepstrum_lsh_close (GstCepstrumLsh * lsh);
+
+guint gst_cepstrum_lsh_get_dim (const GstCepstrumLsh * lsh);
+guint64 gst_cepstrum_lsh_get_num_entries (const GstCepstrumLsh * lsh);
+
+guint gst_cepstrum_lsh_query (GstCepstrumLsh * lsh, const gfloat * features,
+    GstCepstrumLshResult * results, guint max_results);
+
+G_END_DECLS
+
+#endif /* __GST_CEPSTRUM_LSH_H__ */
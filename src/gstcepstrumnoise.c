@@ -0,0 +1,145 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "gstcepstrumnoise.h"
+
+#define NOISE_SMOOTHING     0.85f       /* power smoothing factor */
+#define NOISE_BIAS          1.5f        /* minimum to mean noise power */
+#define NOISE_FLOOR         0.01f       /* spectral floor after subtraction */
+
+struct _GstCepstrumNoise
+{
+  guint num_bins;
+  guint subwin_len;
+  guint num_subwin;
+
+  guint64 num_frames;           /* frames processed since the last reset */
+  guint subwin_frames;          /* frames in the current sub-window */
+  guint subwin_pos;             /* sub-window slot written next */
+  guint subwin_count;           /* completed sub-windows, up to num_subwin */
+
+  gfloat *smoothed;             /* smoothed power */
+  gfloat *cur_min;              /* minimum of the current sub-window */
+  gfloat *subwin_min;           /* minima of the last sub-windows */
+  gfloat *win_min;              /* minimum over the stored sub-windows */
+};
+
+GstCepstrumNoise *
+gst_cepstrum_noise_new (guint num_bins, guint subwin_len, guint num_subwin)
+{
+  GstCepstrumNoise *noise = g_new0 (GstCepstrumNoise, 1);
+
+  noise->num_bins = num_bins;
+  noise->subwin_len = MAX (subwin_len, 1);
+  noise->num_subwin = MAX (num_subwin, 1);
+  noise->smoothed = g_new0 (gfloat, num_bins);
+  noise->cur_min = g_new0 (gfloat, num_bins);
+  noise->subwin_min = g_new0 (gfloat, (gsize) num_bins * noise->num_subwin);
+  noise->win_min = g_new0 (gfloat, num_bins);
+
+  return noise;
+}
+
+void
+gst_cepstrum_noise_free (GstCepstrumNoise * noise)
+{
+  if (noise == NULL)
+    return;
+
+  g_free (noise->smoothed);
+  g_free (noise->cur_min);
+  g_free (noise->subwin_min);
+  g_free (noise->win_min);
+  g_free (noise);
+}
+
+void
+gst_cepstrum_noise_reset (GstCepstrumNoise * noise)
+{
+  noise->num_frames = 0;
+  noise->subwin_frames = 0;
+  noise->subwin_pos = 0;
+  noise->subwin_count = 0;
+}
+
+/* a sub-window is complete, store its minimum and update the window one */
+static void
+noise_next_subwin (GstCepstrumNoise * noise)
+{
+  guint num_bins = noise->num_bins;
+  gfloat *slot = noise->subwin_min + (gsize) noise->subwin_pos * num_bins;
+  guint k, u;
+
+  memcpy (slot, noise->cur_min, num_bins * sizeof (gfloat));
+  noise->subwin_pos = (noise->subwin_pos + 1) % noise->num_subwin;
+  if (noise->subwin_count < noise->num_subwin)
+    noise->subwin_count++;
+
+  memcpy (noise->win_min, noise->subwin_min, num_bins * sizeof (gfloat));
+  for (u = 1; u < noise->subwin_count; u++) {
+    const gfloat *m = noise->subwin_min + (gsize) u * num_bins;
+
+    for (k = 0; k < num_bins; k++)
+      noise->win_min[k] = MIN (noise->win_min[k], m[k]);
+  }
+
+  memcpy (noise->cur_min, noise->smoothed, num_bins * sizeof (gfloat));
+  noise->subwin_frames = 0;
+}
+
+/* update the noise estimate with @power and subtract it in place */
+void
+gst_cepstrum_noise_process (GstCepstrumNoise * noise, gfloat * power,
+    gfloat oversubtraction)
+{
+  guint num_bins = noise->num_bins;
+  gfloat *smoothed = noise->smoothed;
+  gfloat *cur_min = noise->cur_min;
+  guint k;
+
+  if (noise->num_frames == 0) {
+    memcpy (smoothed, power, num_bins * sizeof (gfloat));
+    memcpy (cur_min, power, num_bins * sizeof (gfloat));
+  } else {
+    for (k = 0; k < num_bins; k++) {
+      smoothed[k] = NOISE_SMOOTHING * smoothed[k] +
+          (1.0f - NOISE_SMOOTHING) * power[k];
+      cur_min[k] = MIN (cur_min[k], smoothed[k]);
+    }
+  }
+  noise->num_frames++;
+
+  for (k = 0; k < num_bins; k++) {
+    gfloat n = cur_min[k];
+    gfloat p;
+
+    if (noise->subwin_count > 0)
+      n = MIN (n, noise->win_min[k]);
+    p = power[k] - oversubtraction * NOISE_BIAS * n;
+    power[k] = MAX (p, NOISE_FLOOR * power[k]);
+  }
+
+  if (++noise->subwin_frames == noise->subwin_len)
+    noise_next_subwin (noise);
+}
@@ -0,0 +1,50 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_CEPSTRUM_NOISE_H__
+#define __GST_CEPSTRUM_NOISE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Noise floor tracking and spectral subtraction on power spectrum frames.
+ *
+ * The noise power of every bin is estimated with minimum statistics: the
+ * minimum of the recursively smoothed power over a window of
+ * num_subwin x subwin_len frames, tracked per sub-window so that the
+ * estimate follows a rising floor within one sub-window. The estimate,
+ * scaled by an over-subtraction factor, is subtracted from each frame with
+ * a spectral floor to avoid negative power.
+ */
+
+typedef struct _GstCepstrumNoise GstCepstrumNoise;
+
+GstCepstrumNoise * gst_cepstrum_noise_new (guint num_bins, guint subwin_len,
+    guint num_subwin);
+void gst_cepstrum_noise_free (GstCepstrumNoise * noise);
+void gst_cepstrum_noise_reset (GstCepstrumNoise * noise);
+
+void gst_cepstrum_noise_process (GstCepstrumNoise * noise, gfloat * power,
+    gfloat oversubtraction);
+
+G_END_DECLS
+
+#endif /* __GST_CEPSTRUM_NOISE_H__ */
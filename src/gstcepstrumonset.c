@@ -0,0 +1,148 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "gstcepstrumonset.h"
+
+struct _GstCepstrumOnset
+{
+  guint num_bands;
+  gfloat *last_bands;           /* bands of the previous frame */
+  guint64 num_frames;           /* frames pushed since the last reset */
+
+  /* candidate frame, waiting for the next flux to confirm the maximum */
+  gfloat prev_flux;
+  gfloat cand_flux;
+  guint64 cand_ts;
+
+  guint median_len;
+  gfloat *history;              /* ring of past flux values */
+  gfloat *sorted;               /* scratch for the median */
+  guint history_len;
+  guint history_pos;
+};
+
+GstCepstrumOnset *
+gst_cepstrum_onset_new (guint num_bands, guint median_len)
+{
+  GstCepstrumOnset *onset = g_new0 (GstCepstrumOnset, 1);
+
+  onset->num_bands = num_bands;
+  onset->last_bands = g_new0 (gfloat, num_bands);
+  onset->median_len = MAX (median_len, 1);
+  onset->history = g_new0 (gfloat, onset->median_len);
+  onset->sorted = g_new0 (gfloat, onset->median_len);
+
+  return onset;
+}
+
+void
+gst_cepstrum_onset_free (GstCepstrumOnset * onset)
+{
+  if (onset == NULL)
+    return;
+
+  g_free (onset->last_bands);
+  g_free (onset->history);
+  g_free (onset->sorted);
+  g_free (onset);
+}
+
+void
+gst_cepstrum_onset_reset (GstCepstrumOnset * onset)
+{
+  onset->num_frames = 0;
+  onset->prev_flux = 0.0f;
+  onset->cand_flux = 0.0f;
+  onset->history_len = 0;
+  onset->history_pos = 0;
+}
+
+static gfloat
+onset_median (GstCepstrumOnset * onset)
+{
+  gfloat *v = onset->sorted;
+  guint n = onset->history_len;
+  guint i, j;
+
+  if (n == 0)
+    return 0.0f;
+
+  /* the window is short, insertion sort is fine */
+  for (i = 0; i < n; i++) {
+    gfloat x = onset->history[i];
+
+    for (j = i; j > 0 && v[j - 1] > x; j--)
+      v[j] = v[j - 1];
+    v[j] = x;
+  }
+
+  return (n & 1) ? v[n / 2] : 0.5f * (v[n / 2 - 1] + v[n / 2]);
+}
+
+/* push the bands of the next frame; returns TRUE and sets @onset_ts and
+ * @strength when the previous frame turned out to be an onset */
+gboolean
+gst_cepstrum_onset_push (GstCepstrumOnset * onset, const gfloat * bands,
+    guint64 timestamp, gfloat threshold, guint64 * onset_ts,
+    gfloat * strength)
+{
+  gfloat flux = 0.0f, median;
+  gboolean found = FALSE;
+  guint k;
+
+  if (onset->num_frames > 0) {
+    for (k = 0; k < onset->num_bands; k++) {
+      gfloat d = bands[k] - onset->last_bands[k];
+
+      if (d > 0.0f)
+        flux += d;
+    }
+    flux /= onset->num_bands;
+  }
+  memcpy (onset->last_bands, bands, onset->num_bands * sizeof (gfloat));
+
+  /* the candidate is a peak if it is above both of its neighbours */
+  median = onset_median (onset);
+  if (onset->num_frames > 1 && onset->cand_flux > onset->prev_flux &&
+      onset->cand_flux >= flux && onset->cand_flux > median + threshold) {
+    *onset_ts = onset->cand_ts;
+    *strength = onset->cand_flux - median;
+    found = TRUE;
+  }
+
+  /* the median threshold is taken over the flux preceding the candidate */
+  if (onset->num_frames > 0) {
+    onset->history[onset->history_pos] = onset->cand_flux;
+    onset->history_pos = (onset->history_pos + 1) % onset->median_len;
+    if (onset->history_len < onset->median_len)
+      onset->history_len++;
+  }
+
+  onset->prev_flux = onset->cand_flux;
+  onset->cand_flux = flux;
+  onset->cand_ts = timestamp;
+  onset->num_frames++;
+
+  return found;
+}
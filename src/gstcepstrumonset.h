@@ -0,0 +1,50 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_CEPSTRUM_ONSET_H__
+#define __GST_CEPSTRUM_ONSET_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Onset detector working on log Mel energy frames.
+ *
+ * The detection function is the spectral flux, the mean positive change of
+ * the log energies between consecutive frames. A frame is an onset when its
+ * flux is a local maximum and exceeds the median flux of the preceding
+ * frames by more than a threshold. Decisions are one frame late, since the
+ * following frame is needed to find the maximum.
+ */
+
+typedef struct _GstCepstrumOnset GstCepstrumOnset;
+
+GstCepstrumOnset * gst_cepstrum_onset_new (guint num_bands,
+    guint median_len);
+void gst_cepstrum_onset_free (GstCepstrumOnset * onset);
+void gst_cepstrum_onset_reset (GstCepstrumOnset * onset);
+
+gboolean gst_cepstrum_onset_push (GstCepstrumOnset * onset,
+    const gfloat * bands, guint64 timestamp, gfloat threshold,
+    guint64 * onset_ts, gfloat * strength);
+
+G_END_DECLS
+
+#endif /* __GST_CEPSTRUM_ONSET_H__ */
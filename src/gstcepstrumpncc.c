@@ -0,0 +1,195 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+#include "gstcepstrumpncc.h"
+
+#define PNCC_MEDIUM_FRAMES  5   /* frames of the medium-time power */
+#define PNCC_LAMBDA_A       0.999f      /* rising asymmetric filter pole */
+#define PNCC_LAMBDA_B       0.5f        /* falling asymmetric filter pole */
+#define PNCC_LAMBDA_T       0.85f       /* temporal masking decay */
+#define PNCC_MU_T           0.2f        /* masked power ratio */
+#define PNCC_EXCITATION     2.0f        /* power to floor ratio of speech */
+#define PNCC_SMOOTH_BANDS   4   /* bands on each side of the weight smoothing */
+#define PNCC_LAMBDA_MU      0.999f      /* mean power normalization pole */
+#define PNCC_EXPONENT       (1.0f / 15.0f)
+#define PNCC_FLOOR          1e-20f
+
+struct _GstCepstrumPncc
+{
+  guint num_bands;
+
+  guint64 num_frames;           /* frames processed since the last reset */
+  guint ring_pos;               /* ring slot written next */
+
+  gfloat *ring;                 /* band powers of the last medium frames */
+  gfloat *sum;                  /* sum of the ring per band */
+  gfloat *lower;                /* lower envelope of the medium-time power */
+  gfloat *floor;                /* floor of the noise suppressed power */
+  gfloat *peak;                 /* decaying peak for temporal masking */
+  gfloat *ratio;                /* processed to medium-time power */
+  gfloat mean_power;            /* running mean for power normalization */
+};
+
+GstCepstrumPncc *
+gst_cepstrum_pncc_new (guint num_bands)
+{
+  GstCepstrumPncc *pncc = g_new0 (GstCepstrumPncc, 1);
+
+  pncc->num_bands = num_bands;
+  pncc->ring = g_new0 (gfloat, (gsize) num_bands * PNCC_MEDIUM_FRAMES);
+  pncc->sum = g_new0 (gfloat, num_bands);
+  pncc->lower = g_new0 (gfloat, num_bands);
+  pncc->floor = g_new0 (gfloat, num_bands);
+  pncc->peak = g_new0 (gfloat, num_bands);
+  pncc->ratio = g_new0 (gfloat, num_bands);
+
+  return pncc;
+}
+
+void
+gst_cepstrum_pncc_free (GstCepstrumPncc * pncc)
+{
+  if (pncc == NULL)
+    return;
+
+  g_free (pncc->ring);
+  g_free (pncc->sum);
+  g_free (pncc->lower);
+  g_free (pncc->floor);
+  g_free (pncc->peak);
+  g_free (pncc->ratio);
+  g_free (pncc);
+}
+
+void
+gst_cepstrum_pncc_reset (GstCepstrumPncc * pncc)
+{
+  pncc->num_frames = 0;
+  pncc->ring_pos = 0;
+  memset (pncc->ring, 0,
+      (gsize) pncc->num_bands * PNCC_MEDIUM_FRAMES * sizeof (gfloat));
+  memset (pncc->sum, 0, pncc->num_bands * sizeof (gfloat));
+}
+
+/* first order lowpass that rises with @lambda_a and falls with @lambda_b */
+static inline gfloat
+pncc_asymmetric (gfloat state, gfloat x, gfloat lambda_a, gfloat lambda_b)
+{
+  gfloat lambda = x >= state ? lambda_a : lambda_b;
+
+  return lambda * state + (1.0f - lambda) * x;
+}
+
+/* turn the band powers of a frame into their power-law compressed,
+ * normalized PNCC values in place */
+void
+gst_cepstrum_pncc_process (GstCepstrumPncc * pncc, gfloat * bands)
+{
+  guint num_bands = pncc->num_bands;
+  gfloat *slot = pncc->ring + (gsize) pncc->ring_pos * num_bands;
+  guint medium_len;
+  gfloat total = 0.0f;
+  guint l, i;
+
+  /* running sum of the ring, recomputed once per lap so rounding errors
+   * do not pile up */
+  if (pncc->ring_pos == 0) {
+    memset (pncc->sum, 0, num_bands * sizeof (gfloat));
+    for (i = 1; i < PNCC_MEDIUM_FRAMES; i++) {
+      const gfloat *p = pncc->ring + (gsize) i * num_bands;
+
+      for (l = 0; l < num_bands; l++)
+        pncc->sum[l] += p[l];
+    }
+  } else {
+    for (l = 0; l < num_bands; l++)
+      pncc->sum[l] -= slot[l];
+  }
+  for (l = 0; l < num_bands; l++) {
+    slot[l] = bands[l];
+    pncc->sum[l] += bands[l];
+  }
+  pncc->ring_pos = (pncc->ring_pos + 1) % PNCC_MEDIUM_FRAMES;
+
+  pncc->num_frames++;
+  medium_len = MIN (pncc->num_frames, PNCC_MEDIUM_FRAMES);
+
+  for (l = 0; l < num_bands; l++) {
+    gfloat medium = MAX (pncc->sum[l] / medium_len, PNCC_FLOOR);
+    gfloat rectified, masked, processed;
+
+    if (pncc->num_frames == 1) {
+      pncc->lower[l] = 0.9f * medium;
+      rectified = medium - pncc->lower[l];
+      pncc->floor[l] = rectified;
+      pncc->peak[l] = rectified;
+    } else {
+      /* asymmetric noise suppression: the lower envelope follows the
+       * noise floor, what is above it is kept */
+      pncc->lower[l] = pncc_asymmetric (pncc->lower[l], medium,
+          PNCC_LAMBDA_A, PNCC_LAMBDA_B);
+      rectified = MAX (medium - pncc->lower[l], 0.0f);
+      pncc->floor[l] = pncc_asymmetric (pncc->floor[l], rectified,
+          PNCC_LAMBDA_A, PNCC_LAMBDA_B);
+    }
+
+    /* temporal masking: power below the decaying peak is attenuated */
+    masked = rectified;
+    if (rectified < PNCC_LAMBDA_T * pncc->peak[l])
+      masked = PNCC_MU_T * pncc->peak[l];
+    pncc->peak[l] = MAX (PNCC_LAMBDA_T * pncc->peak[l], rectified);
+
+    /* only excitation segments keep the masked power, the others are
+     * filled with the floor */
+    processed = medium >= PNCC_EXCITATION * pncc->lower[l] ?
+        MAX (masked, pncc->floor[l]) : pncc->floor[l];
+
+    pncc->ratio[l] = processed / medium;
+  }
+
+  /* smooth the weights across bands and apply them to the frame power */
+  for (l = 0; l < num_bands; l++) {
+    guint first = l > PNCC_SMOOTH_BANDS ? l - PNCC_SMOOTH_BANDS : 0;
+    guint last = MIN (l + PNCC_SMOOTH_BANDS, num_bands - 1);
+    gfloat weight = 0.0f;
+
+    for (i = first; i <= last; i++)
+      weight += pncc->ratio[i];
+    bands[l] *= weight / (last - first + 1);
+    total += bands[l];
+  }
+
+  /* mean power normalization and power law nonlinearity */
+  total /= num_bands;
+  if (pncc->num_frames == 1)
+    pncc->mean_power = total;
+  else
+    pncc->mean_power = PNCC_LAMBDA_MU * pncc->mean_power +
+        (1.0f - PNCC_LAMBDA_MU) * total;
+
+  for (l = 0; l < num_bands; l++)
+    bands[l] = powf (bands[l] / MAX (pncc->mean_power, PNCC_FLOOR),
+        PNCC_EXPONENT);
+}
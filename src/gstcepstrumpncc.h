@@ -0,0 +1,49 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_CEPSTRUM_PNCC_H__
+#define __GST_CEPSTRUM_PNCC_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Power-normalized cepstral coefficient (PNCC) processing of gammatone
+ * band powers, after Kim and Stern.
+ *
+ * The medium-time power of each band, its mean over the last frames, goes
+ * through asymmetric noise suppression and temporal masking. The ratio of
+ * the processed to the medium-time power, smoothed across neighbouring
+ * bands, weights the band power of the frame. The result is normalized by
+ * a running mean power and compressed with a 1/15 power law instead of a
+ * log. The medium-time window only looks back, so no frame is delayed.
+ */
+
+typedef struct _GstCepstrumPncc GstCepstrumPncc;
+
+GstCepstrumPncc * gst_cepstrum_pncc_new (guint num_bands);
+void gst_cepstrum_pncc_free (GstCepstrumPncc * pncc);
+void gst_cepstrum_pncc_reset (GstCepstrumPncc * pncc);
+
+void gst_cepstrum_pncc_process (GstCepstrumPncc * pncc, gfloat * bands);
+
+G_END_DECLS
+
+#endif /* __GST_CEPSTRUM_PNCC_H__ */
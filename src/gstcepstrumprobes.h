@@ -0,0 +1,60 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_CEPSTRUM_PROBES_H__
+#define __GST_CEPSTRUM_PROBES_H__
+
+#include <glib.h>
+
+/* Static USDT probes of the provider gst_cepstrum, for SystemTap, perf or
+ * bpftrace. They are built with -Dusdt=enabled and are a single nop each
+ * until a tracer attaches; without sys/sdt.h they expand to nothing and
+ * their arguments are not evaluated.
+ *
+ *   buffer_start  (element, pts, duration, samples)
+ *   buffer_end    (element, pts, frames)
+ *   batch_start   (element, frames)
+ *   batch_end     (element, frames)
+ *   frame_start   (element, frame index, timestamp)
+ *   frame_end     (element, frame index, timestamp)
+ *   message_post  (element, message name, timestamp)
+ *
+ * Frame indexes count the frames delivered since the last discontinuity,
+ * buffer_end reports the index reached with the buffer. message_post fires
+ * for every element message, the interval `cepstrum` one and all the
+ * `cepstrum-*` ones, with the `timestamp` field of the message.
+ */
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define GST_CEPSTRUM_PROBE2(name, a, b) \
+  DTRACE_PROBE2 (gst_cepstrum, name, a, b)
+#define GST_CEPSTRUM_PROBE3(name, a, b, c) \
+  DTRACE_PROBE3 (gst_cepstrum, name, a, b, c)
+#define GST_CEPSTRUM_PROBE4(name, a, b, c, d) \
+  DTRACE_PROBE4 (gst_cepstrum, name, a, b, c, d)
+#else
+#define GST_CEPSTRUM_PROBE2(name, a, b) G_STMT_START { } G_STMT_END
+#define GST_CEPSTRUM_PROBE3(name, a, b, c) G_STMT_START { } G_STMT_END
+#define GST_CEPSTRUM_PROBE4(name, a, b, c, d) G_STMT_START { } G_STMT_END
+#endif
+
+#endif /* __GST_CEPSTRUM_PROBES_H__ */
@@ -0,0 +1,78 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_CEPSTRUM_SCORER_H__
+#define __GST_CEPSTRUM_SCORER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Interface for scoring modules loaded by the cepstrum element through the
+ * #GstCepstrum:scorer-module property.
+ *
+ * A module is a shared object exporting GST_CEPSTRUM_SCORER_SYMBOL, a function
+ * returning a pointer to a static #GstCepstrumScorerInfo. All callbacks are
+ * invoked from the streaming thread with the element lock held, so they must
+ * not call back into the element.
+ */
+
+#define GST_CEPSTRUM_SCORER_ABI_VERSION 1
+#define GST_CEPSTRUM_SCORER_SYMBOL      "gst_cepstrum_scorer_get_info"
+
+typedef struct _GstCepstrumScorerConfig GstCepstrumScorerConfig;
+typedef struct _GstCepstrumScorerInfo GstCepstrumScorerInfo;
+
+struct _GstCepstrumScorerConfig
+{
+  guint frame_len;              /* number of floats per feature frame */
+  guint num_channels;           /* channels per frame (1 unless multi-channel) */
+  guint num_coeffs;             /* coefficients per channel */
+  guint max_frames;             /* maximum number of frames per batch */
+  guint sample_rate;            /* audio sample rate */
+  const gchar *options;         /* #GstCepstrum:scorer-options, may be NULL */
+};
+
+struct _GstCepstrumScorerInfo
+{
+  guint abi_version;            /* GST_CEPSTRUM_SCORER_ABI_VERSION */
+  const gchar *name;
+
+  /* create a scorer instance for @config, store the number of scores
+   * produced per frame in @num_outputs. Returns NULL on failure. */
+  gpointer (*open) (const GstCepstrumScorerConfig * config,
+      guint * num_outputs);
+
+  /* score @num_frames contiguous frames of @frame_len floats each and write
+   * @num_frames * num_outputs values to @scores. Returns FALSE on failure. */
+  gboolean (*score) (gpointer handle, const gfloat * frames,
+      guint num_frames, guint frame_len, gfloat * scores);
+
+  /* drop any internal history, called on discontinuities */
+  void (*reset) (gpointer handle);
+
+  void (*close) (gpointer handle);
+};
+
+typedef const GstCepstrumScorerInfo * (*GstCepstrumScorerGetInfo) (void);
+
+G_END_DECLS
+
+#endif /* __GST_CEPSTRUM_SCORER_H__ */
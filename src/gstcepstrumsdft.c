@@ -0,0 +1,196 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <math.h>
+#include "gstcepstrumsdft.h"
+
+#define SDFT_RESYNC         65536       /* samples between recomputations */
+#define SDFT_HAMMING_A      0.54
+#define SDFT_HAMMING_B      0.23        /* half the cosine coefficient */
+
+/* one recursive resonator at frequency w */
+typedef struct
+{
+  gdouble re, im;               /* DTFT of the window at w */
+  gdouble rot_re, rot_im;       /* e^(jw) */
+  gdouble in_re, in_im;         /* e^(-jw (win_len - 1)) */
+} SdftResonator;
+
+struct _GstCepstrumSdft
+{
+  guint nfft;
+  guint win_len;
+  guint num_bins;
+  guint *bins;
+
+  SdftResonator *res;           /* three per bin, lower, centre, upper */
+
+  gfloat *history;              /* the last win_len samples */
+  guint history_pos;            /* oldest sample */
+  guint since_resync;
+};
+
+static void
+sdft_resonator_init (SdftResonator * r, gdouble w, guint win_len)
+{
+  r->rot_re = cos (w);
+  r->rot_im = sin (w);
+  r->in_re = cos (w * (win_len - 1));
+  r->in_im = -sin (w * (win_len - 1));
+  r->re = r->im = 0.0;
+}
+
+GstCepstrumSdft *
+gst_cepstrum_sdft_new (guint nfft, guint win_len, const guint * bins,
+    guint num_bins)
+{
+  GstCepstrumSdft *sdft = g_new0 (GstCepstrumSdft, 1);
+  gdouble beta = win_len > 1 ? 2.0 * G_PI / (win_len - 1) : 0.0;
+  guint b;
+
+  sdft->nfft = nfft;
+  sdft->win_len = win_len;
+  sdft->num_bins = num_bins;
+  sdft->bins = g_new (guint, num_bins);
+  memcpy (sdft->bins, bins, num_bins * sizeof (guint));
+  sdft->res = g_new0 (SdftResonator, 3 * num_bins);
+  sdft->history = g_new0 (gfloat, win_len);
+
+  for (b = 0; b < num_bins; b++) {
+    gdouble w = 2.0 * G_PI * bins[b] / nfft;
+
+    sdft_resonator_init (&sdft->res[3 * b], w - beta, win_len);
+    sdft_resonator_init (&sdft->res[3 * b + 1], w, win_len);
+    sdft_resonator_init (&sdft->res[3 * b + 2], w + beta, win_len);
+  }
+
+  return sdft;
+}
+
+void
+gst_cepstrum_sdft_free (GstCepstrumSdft * sdft)
+{
+  if (sdft == NULL)
+    return;
+
+  g_free (sdft->bins);
+  g_free (sdft->res);
+  g_free (sdft->history);
+  g_free (sdft);
+}
+
+void
+gst_cepstrum_sdft_reset (GstCepstrumSdft * sdft)
+{
+  guint i;
+
+  memset (sdft->history, 0, sdft->win_len * sizeof (gfloat));
+  sdft->history_pos = 0;
+  sdft->since_resync = 0;
+  for (i = 0; i < 3 * sdft->num_bins; i++)
+    sdft->res[i].re = sdft->res[i].im = 0.0;
+}
+
+/* recompute every resonator directly from the sample history */
+static void
+sdft_resync (GstCepstrumSdft * sdft)
+{
+  guint win_len = sdft->win_len;
+  guint i, m;
+
+  for (i = 0; i < 3 * sdft->num_bins; i++) {
+    SdftResonator *r = &sdft->res[i];
+    gdouble c = 1.0, s = 0.0, re = 0.0, im = 0.0;
+
+    /* e^(-jwm) by repeated rotation, exact enough over one window */
+    for (m = 0; m < win_len; m++) {
+      gdouble x = sdft->history[(sdft->history_pos + m) % win_len];
+      gdouble t;
+
+      re += x * c;
+      im += x * s;
+      t = c * r->rot_re + s * r->rot_im;
+      s = s * r->rot_re - c * r->rot_im;
+      c = t;
+    }
+    r->re = re;
+    r->im = im;
+  }
+  sdft->since_resync = 0;
+}
+
+void
+gst_cepstrum_sdft_push (GstCepstrumSdft * sdft, const gfloat * samples,
+    guint num_samples)
+{
+  guint n, i, num_res = 3 * sdft->num_bins;
+
+  for (n = 0; n < num_samples; n++) {
+    gdouble x_new = samples[n];
+    gdouble x_old = sdft->history[sdft->history_pos];
+
+    sdft->history[sdft->history_pos] = samples[n];
+    sdft->history_pos = (sdft->history_pos + 1) % sdft->win_len;
+
+    /* S(n) = e^(jw) (S(n-1) - x(n-W)) + x(n) e^(-jw(W-1)) */
+    for (i = 0; i < num_res; i++) {
+      SdftResonator *r = &sdft->res[i];
+      gdouble re = r->re - x_old;
+      gdouble im = r->im;
+
+      r->re = re * r->rot_re - im * r->rot_im + x_new * r->in_re;
+      r->im = re * r->rot_im + im * r->rot_re + x_new * r->in_im;
+    }
+  }
+
+  sdft->since_resync += num_samples;
+  if (sdft->since_resync >= SDFT_RESYNC)
+    sdft_resync (sdft);
+}
+
+/* power of the windowed spectrum, divided by @scale, for the tracked bins;
+ * @power starts at bin @first_bin and its other bins are left alone */
+void
+gst_cepstrum_sdft_power (GstCepstrumSdft * sdft, gfloat * power,
+    guint first_bin, gdouble scale)
+{
+  guint b;
+
+  for (b = 0; b < sdft->num_bins; b++) {
+    const SdftResonator *r = &sdft->res[3 * b];
+    gdouble re = SDFT_HAMMING_A * r[1].re -
+        SDFT_HAMMING_B * (r[0].re + r[2].re);
+    gdouble im = SDFT_HAMMING_A * r[1].im -
+        SDFT_HAMMING_B * (r[0].im + r[2].im);
+
+    power[sdft->bins[b] - first_bin] = (re * re + im * im) / scale;
+  }
+}
+
+gdouble
+gst_cepstrum_sdft_cost (guint num_bins, guint hop)
+{
+  /* three resonators of four multiply-adds per sample and bin */
+  return 12.0 * num_bins * hop;
+}
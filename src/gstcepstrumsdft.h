@@ -0,0 +1,56 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __GST_CEPSTRUM_SDFT_H__
+#define __GST_CEPSTRUM_SDFT_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Sliding DFT over a subset of the bins of an nfft point transform.
+ *
+ * Every sample updates the Hamming windowed spectrum of the last win_len
+ * samples, zero padded to nfft, for the selected bins only. The window is
+ * applied in the frequency domain: each bin is the combination of three
+ * recursive resonators, at the bin frequency and one window period either
+ * side of it. The resonators run in double precision and are recomputed
+ * from the sample history at regular intervals so rounding errors do not
+ * accumulate.
+ */
+
+typedef struct _GstCepstrumSdft GstCepstrumSdft;
+
+GstCepstrumSdft * gst_cepstrum_sdft_new (guint nfft, guint win_len,
+    const guint * bins, guint num_bins);
+void gst_cepstrum_sdft_free (GstCepstrumSdft * sdft);
+void gst_cepstrum_sdft_reset (GstCepstrumSdft * sdft);
+
+void gst_cepstrum_sdft_push (GstCepstrumSdft * sdft, const gfloat * samples,
+    guint num_samples);
+void gst_cepstrum_sdft_power (GstCepstrumSdft * sdft, gfloat * power,
+    guint first_bin, gdouble scale);
+
+/* approximate cost of one frame, in real multiply-adds, for @hop samples */
+gdouble gst_cepstrum_sdft_cost (guint num_bins, guint hop);
+
+G_END_DECLS
+
+#endif /* __GST_CEPSTRUM_SDFT_H__ */
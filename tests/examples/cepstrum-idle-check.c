@@ -0,0 +1,188 @@
+/* GStCepstrum
+ * Copyright (C) <2020> Deji Aribuki <daribuki@ketulabs.ch>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Checks that the first message after consumers come back matches the one
+ * of a fresh element fed the same audio. Messages are turned off in the
+ * middle of an interval, one whole interval passes idle and they are turned
+ * on again at the next interval boundary.
+ *
+ * Built and run by `meson test` when gstreamer-check-1.0 is available.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+
+#define AUDIOFREQ 16000
+#define INTERVAL_SAMPLES (AUDIOFREQ / 2)
+
+/* two tones and a little deterministic noise, from the absolute position so
+ * that any piece of the stream can be generated on its own */
+static GstBuffer *
+make_buffer (guint64 offset, guint samples, gboolean discont)
+{
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, samples * 2, NULL);
+  GstMapInfo map;
+  gint16 *data;
+  guint i;
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  data = (gint16 *) map.data;
+  for (i = 0; i < samples; i++) {
+    guint64 n = offset + i;
+    gdouble v = 0.3 * sin (2.0 * G_PI * 440.0 * n / AUDIOFREQ) +
+        0.2 * sin (2.0 * G_PI * 1250.0 * n / AUDIOFREQ) +
+        0.05 * (((n * 1103515245 + 12345) >> 16) % 2001 - 1000) / 1000.0;
+
+    data[i] = (gint16) (v * 32767);
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) =
+      gst_util_uint64_scale (offset, GST_SECOND, AUDIOFREQ);
+  GST_BUFFER_DURATION (buffer) =
+      gst_util_uint64_scale (samples, GST_SECOND, AUDIOFREQ);
+  if (discont)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+
+  return buffer;
+}
+
+static GstHarness *
+make_harness (GstBus * bus)
+{
+  GstHarness *h = gst_harness_new ("cepstrum");
+
+  /* the hop divides the interval, so both runs share the frame grid */
+  g_object_set (h->element, "interval", GST_SECOND / 2, "window-size", 400,
+      "hop-size", 160, "num-coeffs", 13, NULL);
+  gst_element_set_bus (h->element, bus);
+  gst_harness_set_src_caps_str (h, "audio/x-raw, format=(string)S16LE, "
+      "rate=(int)16000, channels=(int)1, layout=(string)interleaved");
+
+  return h;
+}
+
+static void
+push (GstHarness * h, guint64 offset, guint samples, gboolean discont)
+{
+  if (gst_harness_push (h, make_buffer (offset, samples,
+              discont)) != GST_FLOW_OK) {
+    fprintf (stderr, "push failed\n");
+    exit (1);
+  }
+  gst_buffer_unref (gst_harness_pull (h));
+}
+
+/* the coefficients of the next cepstrum message on @bus */
+static GArray *
+pop_cepstrum (GstBus * bus, GstClockTime * timestamp)
+{
+  GstMessage *msg;
+  const GstStructure *s;
+  const GValue *coeffs;
+  GArray *values = g_array_new (FALSE, FALSE, sizeof (gfloat));
+  guint i;
+
+  while ((msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT)) != NULL) {
+    s = gst_message_get_structure (msg);
+    if (gst_structure_has_name (s, "cepstrum"))
+      break;
+    gst_message_unref (msg);
+  }
+  if (msg == NULL) {
+    fprintf (stderr, "no cepstrum message\n");
+    exit (1);
+  }
+
+  gst_structure_get_clock_time (s, "timestamp", timestamp);
+  coeffs = gst_structure_get_value (s, "coeffs");
+  for (i = 0; i < gst_value_list_get_size (coeffs); i++) {
+    gfloat v = g_value_get_float (gst_value_list_get_value (coeffs, i));
+
+    g_array_append_val (values, v);
+  }
+  gst_message_unref (msg);
+
+  return values;
+}
+
+int
+main (int argc, char *argv[])
+{
+  GstBus *bus_resumed, *bus_fresh;
+  GstHarness *resumed, *fresh;
+  GArray *a, *b;
+  GstClockTime ts_a, ts_b;
+  gboolean ok = TRUE;
+  guint i;
+
+  gst_init (&argc, &argv);
+
+  bus_resumed = gst_bus_new ();
+  resumed = make_harness (bus_resumed);
+
+  /* half an interval analysed, then idle until the third interval */
+  push (resumed, 0, INTERVAL_SAMPLES / 2, TRUE);
+  g_object_set (resumed->element, "post-messages", FALSE, NULL);
+  push (resumed, INTERVAL_SAMPLES / 2, INTERVAL_SAMPLES / 2, FALSE);
+  push (resumed, INTERVAL_SAMPLES, INTERVAL_SAMPLES, FALSE);
+  g_object_set (resumed->element, "post-messages", TRUE, NULL);
+  push (resumed, 2 * INTERVAL_SAMPLES, INTERVAL_SAMPLES, FALSE);
+
+  /* a fresh element starting with that third interval */
+  bus_fresh = gst_bus_new ();
+  fresh = make_harness (bus_fresh);
+  push (fresh, 2 * INTERVAL_SAMPLES, INTERVAL_SAMPLES, TRUE);
+
+  a = pop_cepstrum (bus_resumed, &ts_a);
+  b = pop_cepstrum (bus_fresh, &ts_b);
+
+  if (ts_a != ts_b) {
+    fprintf (stderr, "timestamps differ: %" GST_TIME_FORMAT " and %"
+        GST_TIME_FORMAT "\n", GST_TIME_ARGS (ts_a), GST_TIME_ARGS (ts_b));
+    ok = FALSE;
+  }
+  if (a->len != b->len) {
+    fprintf (stderr, "coefficient counts differ: %u and %u\n", a->len,
+        b->len);
+    ok = FALSE;
+  }
+  for (i = 0; ok && i < a->len; i++) {
+    gfloat x = g_array_index (a, gfloat, i), y = g_array_index (b, gfloat, i);
+
+    if (fabsf (x - y) > 1e-4f * MAX (1.0f, fabsf (y))) {
+      fprintf (stderr, "coefficient %u differs: %f and %f\n", i, x, y);
+      ok = FALSE;
+    }
+  }
+
+  g_print ("%s\n", ok ? "resumed interval matches a fresh run" : "FAILED");
+
+  g_array_free (a, TRUE);
+  g_array_free (b, TRUE);
+  gst_harness_teardown (resumed);
+  gst_harness_teardown (fresh);
+  gst_object_unref (bus_resumed);
+  gst_object_unref (bus_fresh);
+
+  return ok ? 0 : 1;
+}